@@ -0,0 +1,187 @@
+#include "analyze.h"
+#include "io.h"
+#include "misc.h"
+#include "movegen.h"
+#include "search.h"
+#include "threads.h"
+#include "ttable.h"
+#include "uci.h"
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+// Size of the TT of each analysis thread
+constexpr uint64_t ANALYZE_HASH_MB = 16;
+
+// State shared by all the analysis threads
+struct AnalyzeState {
+    // Input side, guarded by inputMutex
+    std::mutex inputMutex;
+    std::ifstream input;
+    uint64_t linesRead = 0;
+    // Output side, guarded by outputMutex, results that are ready before the ones of the previous lines wait in pendingResults
+    std::mutex outputMutex;
+    std::ofstream output;
+    std::map<uint64_t, std::string> pendingResults;
+    uint64_t linesWritten = 0;
+    uint64_t nodes = 0;
+    uint64_t starttime = 0;
+};
+
+// Reads the next non empty line of the input file and its index, returns false once the file is over
+static bool ReadPosition(AnalyzeState* state, std::string& line, uint64_t& index) {
+    std::lock_guard<std::mutex> lock(state->inputMutex);
+    while (std::getline(state->input, line)) {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.find_first_not_of(" \t") == std::string::npos)
+            continue;
+        index = state->linesRead++;
+        return true;
+    }
+    return false;
+}
+
+// Turns an EPD or FEN line into a FEN ParseFen can handle, EPD operations are dropped, returns false if the line can't be a position
+static bool ExtractFen(const std::string& line, std::string& fen) {
+    const std::vector<std::string> tokens = split_command(line);
+    if (tokens.size() < 4 || (tokens[1] != "w" && tokens[1] != "b"))
+        return false;
+    fen = tokens[0] + " " + tokens[1] + " " + tokens[2] + " " + tokens[3];
+    // FENs also carry the move counters, EPDs might have opcodes in their place
+    const auto isNumber = [](const std::string& token) { return token.find_first_not_of("0123456789") == std::string::npos; };
+    if (tokens.size() >= 6 && isNumber(tokens[4]) && isNumber(tokens[5]))
+        fen += " " + tokens[4] + " " + tokens[5];
+    // ParseFen trusts the board string, so make sure it at least describes 8 ranks of 8 squares
+    int rank = 0;
+    int file = 0;
+    for (const char c : tokens[0]) {
+        if (c == '/') {
+            if (file != 8)
+                return false;
+            rank++;
+            file = 0;
+        }
+        else if (c >= '1' && c <= '8')
+            file += c - '0';
+        else if (std::string("PNBRQKpnbrqk").find(c) != std::string::npos)
+            file++;
+        else
+            return false;
+        if (file > 8)
+            return false;
+    }
+    return rank == 7 && file == 8;
+}
+
+// Formats a score the same way the uci output does
+static std::string FormatScore(const int score) {
+    if (score > -MATE_SCORE && score < -MATE_FOUND)
+        return "mate " + std::to_string(-(score + MATE_SCORE) / 2);
+    if (score > MATE_FOUND && score < MATE_SCORE)
+        return "mate " + std::to_string((MATE_SCORE - score) / 2 + 1);
+    return "cp " + std::to_string(int(score / 2.5));
+}
+
+// Searches the position of the line and returns the line to write in the output file
+static std::string AnalyzePosition(ThreadData* td, UciOptions* options, const std::string& line, const int depth, const uint64_t nodes) {
+    std::string fen;
+    if (!ExtractFen(line, fen))
+        return line + " ; error invalid position";
+
+    ParseFen(fen, &td->pos);
+    if (CountBits(td->pos.getPieceColorBB(KING, WHITE)) != 1 || CountBits(td->pos.getPieceColorBB(KING, BLACK)) != 1)
+        return line + " ; error invalid position";
+
+    std::ostringstream result;
+    result << line << " ;";
+
+    // Positions that are already over have nothing to search
+    MoveList legalMoves;
+    GenerateLegalMoves(&legalMoves, &td->pos);
+    if (legalMoves.count == 0) {
+        result << " bestmove (none) score " << (td->pos.getCheckers() ? "mate 0" : "cp 0") << " depth 0 nodes 0";
+        return result.str();
+    }
+
+    td->info.Reset();
+    td->info.depth = depth;
+    if (nodes) {
+        td->info.nodeset = true;
+        td->info.nodeslimit = nodes;
+    }
+    td->info.starttime = td->info.tmStartTime = GetTimeMs();
+    SearchPosition(1, depth, td, options);
+
+    result << " bestmove " << FormatMove(GetBestMove(td))
+           << " score " << FormatScore(td->completedScore)
+           << " depth " << td->completedDepth
+           << " nodes " << td->info.nodes
+           << " pv";
+    for (int i = 0; i < std::max(td->pvTable.pvLength[0], 1); i++)
+        result << " " << FormatMove(td->pvTable.pvArray[0][i]);
+    return result.str();
+}
+
+// Stores the result of the line and writes every result that is now next in line
+static void WriteResult(AnalyzeState* state, const uint64_t index, std::string&& result, const uint64_t nodes) {
+    std::lock_guard<std::mutex> lock(state->outputMutex);
+    state->pendingResults.emplace(index, std::move(result));
+    state->nodes += nodes;
+    for (auto it = state->pendingResults.find(state->linesWritten); it != state->pendingResults.end(); it = state->pendingResults.find(state->linesWritten)) {
+        state->output << it->second << "\n";
+        state->pendingResults.erase(it);
+        state->linesWritten++;
+        if (state->linesWritten % 1000 == 0) {
+            const uint64_t time = GetTimeMs() - state->starttime;
+            std::cout << "positions " << state->linesWritten << " nps " << state->nodes * 1000 / (time + 1) << std::endl;
+        }
+    }
+}
+
+// Searches positions on its own ThreadData and TT until the input file is over
+static void AnalyzeWorker(const int depth, const uint64_t nodes, AnalyzeState* state) {
+    StandaloneThread thread(ANALYZE_HASH_MB);
+    ThreadData* td = thread.td.get();
+    UciOptions options;
+
+    std::string line;
+    uint64_t index;
+    while (ReadPosition(state, line, index)) {
+        std::string result = AnalyzePosition(td, &options, line, depth, nodes);
+        WriteResult(state, index, std::move(result), td->info.nodes);
+    }
+}
+
+void StartAnalyze(const std::string& inputFile, int threadCount, int depth, uint64_t nodes, const std::string& outputFile) {
+    AnalyzeState state;
+    state.input.open(inputFile);
+    if (!state.input) {
+        std::cout << "Could not open " << inputFile << std::endl;
+        return;
+    }
+    state.output.open(outputFile);
+    if (!state.output) {
+        std::cout << "Could not open " << outputFile << std::endl;
+        return;
+    }
+    state.starttime = GetTimeMs();
+
+    // The search output would just slow us down
+    const bool oldTryhardmode = tryhardmode;
+    tryhardmode = true;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back(AnalyzeWorker, depth, nodes, &state);
+    for (auto& worker : workers)
+        worker.join();
+
+    tryhardmode = oldTryhardmode;
+    const uint64_t time = GetTimeMs() - state.starttime;
+    std::cout << "Analyzed " << state.linesWritten << " positions in " << time << " ms, " << state.nodes * 1000 / (time + 1) << " nps, results written to " << outputFile << std::endl;
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// Searches every FEN/EPD position of the input file on threadCount threads, each with its own TT, up to depth (and nodes if not 0)
+// and writes bestmove, score, depth, nodes and pv of each position to the output file in the same order as the input
+void StartAnalyze(const std::string& inputFile, int threadCount, int depth, uint64_t nodes, const std::string& outputFile);
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include "types.h"
 #include "position.h"
 
@@ -19,105 +20,313 @@ constexpr Bitboard rank_2_mask = 65280ULL;
 
 constexpr Bitboard rank_7_mask = 71776119061217280ULL;
 
-// bishop relevant occupancy bit count for every square on board
-constexpr int bishop_shift = 55;
+// Fancy magics: the attacks of each square take 2^(relevant occupancy bits) entries of a table shared by all the sliders,
+// so every square has its own shift (64 - relevant bits) and its own offset into the table.
+// Aligned so that looking up a square never touches 2 cache lines
+struct alignas(32) SliderMagic {
+    Bitboard mask;
+    Bitboard magic;
+    uint32_t offset;
+    uint32_t shift;
+};
 
-// rook relevant occupancy bit count for every square on board
-constexpr int rook_shift = 52;
+// Entries of the shared slider attacks table, the bishop ones come first
+constexpr int BISHOP_TABLE_SIZE = 5248;
+constexpr int ROOK_TABLE_SIZE = 102400;
+constexpr int SLIDER_TABLE_SIZE = BISHOP_TABLE_SIZE + ROOK_TABLE_SIZE;
 
 // rook magic numbers
 constexpr Bitboard rook_magic_numbers[64] = {
-    0x8a80104000800020ULL, 0x84020100804000ULL, 0x800a1000048020ULL,
-    0xc4100020b1000200ULL, 0x400440002080420ULL, 0xa8004002a801200ULL,
-    0x840140c80400100ULL, 0x10000820c412300ULL, 0x10800212400820ULL,
-    0x8050190002800ULL, 0x1080800102000ULL, 0x41080080201001ULL,
-    0x20820040800890aULL, 0x10800200008440ULL, 0x3200800418a0022ULL,
-    0x250060600201100ULL, 0x4440002400860020ULL, 0x1004402800084000ULL,
-    0x41404c0140004ULL, 0x5000400908001400ULL, 0x20841000830ULL,
-    0x830a0101000500ULL, 0x14040a002804040ULL, 0x4400101008854220ULL,
-    0xe008025220022600ULL, 0x440244008603000ULL, 0x8024004009000ULL,
-    0x801009002100002ULL, 0x400200200010811ULL, 0x3204020044012400ULL,
-    0x2100088200100ULL, 0x20800a004091041ULL, 0x210c224200241ULL,
-    0x200a0c02040080ULL, 0x4d8028104c0800ULL, 0x813c0a0002900012ULL,
-    0x8104200208020ULL, 0x240400a000a04080ULL, 0x802199100100042ULL,
-    0x62c4c0020100280ULL, 0x20104280800820ULL, 0x20c8010080a80200ULL,
-    0x1114084080464008ULL, 0x2000025430001805ULL, 0x1404c4a100110008ULL,
-    0x8400012008ULL, 0x3045140080022010ULL, 0x8040028410080100ULL,
-    0x220200310204820ULL, 0x200082244048202ULL, 0x90984c0208022ULL,
-    0x8000110120040900ULL, 0x9000402400080084ULL, 0x2402100100038020ULL,
-    0x98400600008028ULL, 0x111000040200cULL, 0x102402208108102ULL,
-    0x440041482204101ULL, 0x4004402000040811ULL, 0x804a000810402002ULL,
-    0x8000209020401ULL, 0x440341108009002ULL, 0x8825084204ULL,
-    0x2084002112428402ULL
+    0xa680042040001480ULL, 0x40c0014010002000ULL, 0x200100820804202ULL,
+    0x900100008210004ULL, 0x4a00108402000820ULL, 0x2200040200018810ULL,
+    0x3000100220008acULL, 0x4080002044800d00ULL, 0x8c800080400820ULL,
+    0x400240012002d000ULL, 0x1001041002008ULL, 0x110801000080080ULL,
+    0x1000500100800ULL, 0x8a46000408020010ULL, 0x40010084104a2ULL,
+    0x14a000220804401ULL, 0x80102a8000400088ULL, 0x20008020804000ULL,
+    0x4010008010200081ULL, 0x208010100100020ULL, 0x2091010008001005ULL,
+    0x2008080020400ULL, 0x240024001110c208ULL, 0x400120001008054ULL,
+    0x8080208080004004ULL, 0x80dd5004c0042000ULL, 0x410040120080120ULL,
+    0x2000d00180380080ULL, 0x8000880040080ULL, 0x100a000200080410ULL,
+    0x300080400100102ULL, 0x6200008200011044ULL, 0x61481400c800060ULL,
+    0x1001004001002084ULL, 0x200080801000ULL, 0x840010010100200bULL,
+    0x28040080800800ULL, 0x882000406001830ULL, 0x1005421001200ULL,
+    0x1804600010cULL, 0x804000208000ULL, 0x4400402010044000ULL,
+    0x4010008020028014ULL, 0x90410010020ULL, 0x80100110005ULL,
+    0xa00201004080140ULL, 0x40200010100ULL, 0x220007081020004ULL,
+    0x840205c981002a00ULL, 0x804000200480ULL, 0x2081040802200ULL,
+    0x240230010000900ULL, 0x44800800240180ULL, 0x4011000400080300ULL,
+    0x101011088a0c00ULL, 0x1003000080420100ULL, 0x180102100408001ULL,
+    0x1100108040010021ULL, 0x182004008108022ULL, 0x122900128202501ULL,
+    0x2012004100802ULL, 0xc200834c081002ULL, 0x440020110083084ULL,
+    0x4000484884010022ULL
 };
 
 // bishop magic numbers
 constexpr Bitboard bishop_magic_numbers[64] = {
-    0x80810410820200ULL, 0x2010520422401000ULL, 0x88a01411a0081800ULL,
-    0x1001050002610001ULL, 0x9000908280000000ULL, 0x20080442a0000001ULL,
-    0x221a80045080800ULL, 0x60200a404000ULL, 0x20100894408080ULL,
-    0x800084021404602ULL, 0x40804100298014ULL, 0x5080201060400011ULL,
-    0x49000620a0000000ULL, 0x8000001200300000ULL, 0x4000008241100060ULL,
-    0x40920160200ULL, 0x42002000240090ULL, 0x484100420a804ULL,
-    0x8000102000910ULL, 0x4880010a8100202ULL, 0x4018804040402ULL,
-    0x202100108281120ULL, 0xc201162010101042ULL, 0x240088022010b80ULL,
-    0x8301600c240814ULL, 0x28100e142050ULL, 0x20880000838110ULL,
-    0x410800040204a0ULL, 0x2012002206008040ULL, 0x4402881900a008ULL,
-    0x14a80004804c1080ULL, 0xa004814404800f02ULL, 0xc0180230101600ULL,
-    0xc905200020080ULL, 0x60400080010404aULL, 0x40401080c0100ULL,
-    0x20121010140040ULL, 0x500080000861ULL, 0x8202090241002020ULL,
-    0x2008022008002108ULL, 0x200402401042000ULL, 0x2e03210042000ULL,
-    0x110040080422400ULL, 0x908404c0584040c0ULL, 0x1000204202240408ULL,
-    0x8002002200200200ULL, 0x2002008101081414ULL, 0x2080021098404ULL,
-    0x60110080680000ULL, 0x1080048108420000ULL, 0x400184014100000ULL,
-    0x8081a004012240ULL, 0x110080448182a0ULL, 0xa4002000604a4000ULL,
-    0x4002811049020ULL, 0x24a0410a10220ULL, 0x808090089013000ULL,
-    0xc80800400805800ULL, 0x1020100061618ULL, 0x1202820040501008ULL,
-    0x413010050c100405ULL, 0x4248204042020ULL, 0x44004408280110ULL,
-    0x6010220080600502ULL
+    0x2008021012002502ULL, 0x4d0100110628400ULL, 0x21102080a1021010ULL,
+    0x2044041080000400ULL, 0x4050402800000ULL, 0x2010420109560ULL,
+    0x8040084500a0000ULL, 0x9401002104224008ULL, 0x40044350070b0100ULL,
+    0x90b00888088c1040ULL, 0x100100440444012ULL, 0x80001104008a0940ULL,
+    0x1042920210504048ULL, 0x10420048200ULL, 0xa410221000ULL,
+    0x804800829c901001ULL, 0x40002008010120ULL, 0x8802008424280205ULL,
+    0x200800010a040010ULL, 0x2420800802004008ULL, 0x12011402a21220ULL,
+    0x2002028508022208ULL, 0x486200049100802ULL, 0x2000211101080200ULL,
+    0x8020200044140c60ULL, 0x810680c05080381ULL, 0x1442028012400ULL,
+    0x4028088008020002ULL, 0x25c1001041004010ULL, 0x401020049080140ULL,
+    0x4004084210400ULL, 0x40010900104400a0ULL, 0x11011480004a800ULL,
+    0x82020200a0680bULL, 0x800203000080082ULL, 0x5020081880080ULL,
+    0x1050120080001004ULL, 0x20008880030810ULL, 0x2241180900008c30ULL,
+    0x201451101012400ULL, 0x8444016008025000ULL, 0x2080104000800ULL,
+    0x2801001490090200ULL, 0x500142018001100ULL, 0x300040408200400ULL,
+    0x8008800820810ULL, 0x804210204004212ULL, 0x800a698800202ULL,
+    0x411040202401000ULL, 0xa008c051802000eULL, 0x1002a100a8040022ULL,
+    0xc0084042600ULL, 0x1000884048220000ULL, 0x82200410208000ULL,
+    0x222020441140022ULL, 0x1004080800408810ULL, 0x22410801500201ULL,
+    0x10000410818020bULL, 0x2044000044040410ULL, 0x200c0100208801ULL,
+    0x80800200a102400ULL, 0x404c010020090ULL, 0x1002101418808c03ULL,
+    0x11300081040020ULL
 };
 
 // generate pawn attacks
-[[nodiscard]] Bitboard MaskPawnAttacks(int side, int square);
+[[nodiscard]] constexpr Bitboard MaskPawnAttacks(int side, int square) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+    // piece bitboard
+    Bitboard bitboard = 0ULL;
+    // set piece on board
+    set_bit(bitboard, square);
+    // white pawns
+    if (!side) {
+        // generate pawn attacks
+        if ((bitboard >> 7) & not_a_file)
+            attacks |= (bitboard >> 7);
+        if ((bitboard >> 9) & not_h_file)
+            attacks |= (bitboard >> 9);
+    }
+    // black pawns
+    else {
+        // generate pawn attacks
+        if ((bitboard << 7) & not_h_file)
+            attacks |= (bitboard << 7);
+        if ((bitboard << 9) & not_a_file)
+            attacks |= (bitboard << 9);
+    }
+    // return attack map
+    return attacks;
+}
 
 // generate knight attacks
-[[nodiscard]] Bitboard MaskKnightAttacks(int square);
+[[nodiscard]] constexpr Bitboard MaskKnightAttacks(int square) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+    // piece bitboard
+    Bitboard bitboard = 0ULL;
+    // set piece on board
+    set_bit(bitboard, square);
+    // generate knight attacks
+    if ((bitboard >> 17) & not_h_file)
+        attacks |= (bitboard >> 17);
+    if ((bitboard >> 15) & not_a_file)
+        attacks |= (bitboard >> 15);
+    if ((bitboard >> 10) & not_hg_file)
+        attacks |= (bitboard >> 10);
+    if ((bitboard >> 6) & not_ab_file)
+        attacks |= (bitboard >> 6);
+    if ((bitboard << 17) & not_a_file)
+        attacks |= (bitboard << 17);
+    if ((bitboard << 15) & not_h_file)
+        attacks |= (bitboard << 15);
+    if ((bitboard << 10) & not_ab_file)
+        attacks |= (bitboard << 10);
+    if ((bitboard << 6) & not_hg_file)
+        attacks |= (bitboard << 6);
+
+    // return attack map
+    return attacks;
+}
 
 // generate king attacks
-[[nodiscard]] Bitboard MaskKingAttacks(int square);
+[[nodiscard]] constexpr Bitboard MaskKingAttacks(int square) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+
+    // piece bitboard
+    Bitboard bitboard = 0ULL;
+
+    // set piece on board
+    set_bit(bitboard, square);
+
+    // generate king attacks
+    if (bitboard >> 8)
+        attacks |= (bitboard >> 8);
+    if ((bitboard >> 9) & not_h_file)
+        attacks |= (bitboard >> 9);
+    if ((bitboard >> 7) & not_a_file)
+        attacks |= (bitboard >> 7);
+    if ((bitboard >> 1) & not_h_file)
+        attacks |= (bitboard >> 1);
+    if (bitboard << 8)
+        attacks |= (bitboard << 8);
+    if ((bitboard << 9) & not_a_file)
+        attacks |= (bitboard << 9);
+    if ((bitboard << 7) & not_h_file)
+        attacks |= (bitboard << 7);
+    if ((bitboard << 1) & not_a_file)
+        attacks |= (bitboard << 1);
+
+    // return attack map
+    return attacks;
+}
 
 // mask bishop attacks
-[[nodiscard]] Bitboard MaskBishopAttacks(int square);
+[[nodiscard]] constexpr Bitboard MaskBishopAttacks(int square) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+
+    // init target rank & files
+    int tr = square / 8;
+    int tf = square % 8;
+
+    // mask relevant bishop occupancy bits
+    for (int r = tr + 1, f = tf + 1; r <= 6 && f <= 6; r++, f++)
+        attacks |= (1ULL << (r * 8 + f));
+    for (int r = tr - 1, f = tf + 1; r >= 1 && f <= 6; r--, f++)
+        attacks |= (1ULL << (r * 8 + f));
+    for (int r = tr + 1, f = tf - 1; r <= 6 && f >= 1; r++, f--)
+        attacks |= (1ULL << (r * 8 + f));
+    for (int r = tr - 1, f = tf - 1; r >= 1 && f >= 1; r--, f--)
+        attacks |= (1ULL << (r * 8 + f));
+
+    // return attack map
+    return attacks;
+}
 
 // mask rook attacks
-[[nodiscard]] Bitboard MaskRookAttacks(int square);
+[[nodiscard]] constexpr Bitboard MaskRookAttacks(int square) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+    // init target rank & files
+    int tr = square / 8;
+    int tf = square % 8;
+    // mask relevant rook occupancy bits
+    for (int r = tr + 1; r <= 6; r++)
+        attacks |= (1ULL << (r * 8 + tf));
+    for (int r = tr - 1; r >= 1; r--)
+        attacks |= (1ULL << (r * 8 + tf));
+    for (int f = tf + 1; f <= 6; f++)
+        attacks |= (1ULL << (tr * 8 + f));
+    for (int f = tf - 1; f >= 1; f--)
+        attacks |= (1ULL << (tr * 8 + f));
+    // return attack map
+    return attacks;
+}
 
 // generate bishop attacks on the fly
-[[nodiscard]] Bitboard BishopAttacksOnTheFly(int square, Bitboard block);
+[[nodiscard]] constexpr Bitboard BishopAttacksOnTheFly(int square, Bitboard block) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+    // init target rank & files
+    int tr = square / 8;
+    int tf = square % 8;
+    // generate bishop atacks
+    for (int r = tr + 1, f = tf + 1; r <= 7 && f <= 7; r++, f++) {
+        const Bitboard bit = 1ULL << (r * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int r = tr - 1, f = tf + 1; r >= 0 && f <= 7; r--, f++) {
+        const Bitboard bit = 1ULL << (r * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int r = tr + 1, f = tf - 1; r <= 7 && f >= 0; r++, f--) {
+        const Bitboard bit = 1ULL << (r * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int r = tr - 1, f = tf - 1; r >= 0 && f >= 0; r--, f--) {
+        const Bitboard bit = 1ULL << (r * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+    // return attack map
+    return attacks;
+}
 
 // generate rook attacks on the fly
-[[nodiscard]] Bitboard RookAttacksOnTheFly(int square, Bitboard block);
+[[nodiscard]] constexpr Bitboard RookAttacksOnTheFly(int square, Bitboard block) {
+    // result attacks bitboard
+    Bitboard attacks = 0ULL;
+    // init target rank & files
+    int tr = square / 8;
+    int tf = square % 8;
+    // generate rook attacks
+    for (int r = tr + 1; r <= 7; r++) {
+        const Bitboard bit = 1ULL << (r * 8 + tf);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int r = tr - 1; r >= 0; r--) {
+        const Bitboard bit = 1ULL << (r * 8 + tf);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int f = tf + 1; f <= 7; f++) {
+        const Bitboard bit = 1ULL << (tr * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+
+    for (int f = tf - 1; f >= 0; f--) {
+        const Bitboard bit = 1ULL << (tr * 8 + f);
+        attacks |= bit;
+        if (bit & block)
+            break;
+    }
+    // return attack map
+    return attacks;
+}
+
+// The attack tables are generated at compile time in init.cpp, so they start out in the read only data of the binary
 
 // pawn attacks table [side][square]
-extern Bitboard pawn_attacks[2][64];
+extern const std::array<std::array<Bitboard, 64>, 2> pawn_attacks;
 
 // knight attacks table [square]
-extern Bitboard knight_attacks[64];
+extern const std::array<Bitboard, 64> knight_attacks;
 
 // king attacks table [square]
-extern Bitboard king_attacks[64];
+extern const std::array<Bitboard, 64> king_attacks;
 
-// bishop attack masks
-extern Bitboard bishop_masks[64];
+// bishop masks, magics and table offsets [square]
+extern const std::array<SliderMagic, 64> bishop_magics;
 
-// rook attack masks
-extern Bitboard rook_masks[64];
+// rook masks, magics and table offsets [square]
+extern const std::array<SliderMagic, 64> rook_magics;
 
-// bishop attacks table [square][occupancies]
-extern Bitboard bishop_attacks[64][512];
+// bishop and rook attacks table [offset of the square + occupancy index]
+extern const std::array<Bitboard, SLIDER_TABLE_SIZE> slider_attacks;
 
-// rook attacks rable [square][occupancies]
-extern Bitboard rook_attacks[64][4096];
+// index of the attacks of a slider in the shared table
+[[nodiscard]] inline uint32_t SliderIndex(const SliderMagic& entry, const Bitboard occupancy) {
+#if defined (USE_PEXT)
+    return entry.offset + static_cast<uint32_t>(_pext_u64(occupancy, entry.mask));
+#else
+    return entry.offset + static_cast<uint32_t>(((occupancy & entry.mask) * entry.magic) >> entry.shift);
+#endif
+}
 
 [[nodiscard]] inline Bitboard getPawnAttacks(const Square square, const int side) {
     return pawn_attacks[side][square];
@@ -129,28 +338,12 @@ extern Bitboard rook_attacks[64][4096];
 
 // get bishop attacks
 [[nodiscard]] inline Bitboard getBishopAttacks(const Square square, Bitboard occupancy) {
-    // get bishop attacks assuming current board occupancy
-    auto mask = bishop_masks[square];
-#if defined (USE_PEXT)
-    auto index = static_cast<uint32_t>(_pext_u64(occupancy, mask));
-#else
-    auto index = (occupancy & mask) * bishop_magic_numbers[square] >> bishop_shift;
-#endif
-    // return rook attacks
-    return bishop_attacks[square][index];
+    return slider_attacks[SliderIndex(bishop_magics[square], occupancy)];
 }
 
 // get rook attacks
 [[nodiscard]] inline Bitboard getRookAttacks(const Square square, Bitboard occupancy) {
-    // get rook attacks assuming current board occupancy
-    auto mask = rook_masks[square];
-#if defined (USE_PEXT)
-    auto index = static_cast<uint32_t>(_pext_u64(occupancy, mask));
-#else
-    auto index = (occupancy & mask) * rook_magic_numbers[square] >> rook_shift;
-#endif
-    // return rook attacks
-    return rook_attacks[square][index];
+    return slider_attacks[SliderIndex(rook_magics[square], occupancy)];
 }
 
 // get queen attacks
@@ -181,6 +374,3 @@ extern Bitboard rook_attacks[64][4096];
     }
 }
 
-// set occupancies
-[[nodiscard]] Bitboard SetOccupancy(int index, int bits_in_mask, Bitboard attack_mask);
-
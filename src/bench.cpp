@@ -1,3 +1,4 @@
+#include "bench.h"
 #include "ttable.h"
 #include "init.h"
 #include "misc.h"
@@ -6,6 +7,8 @@
 #include "eval.h"
 #include "uci.h"
 #include "search.h"
+#include "threads.h"
+#include "time_manager.h"
 
 // Benchmarks from Bitgenie
 const char* benchmarkfens[52] = {
@@ -62,24 +65,61 @@ const char* benchmarkfens[52] = {
     "8/P6p/2K1q1pk/2Q5/4p3/8/7P/8 w - - 4 44"
 };
 
-void StartBench(int depth) {
-    // init all
+struct BenchResult {
+    uint64_t nodes = 0;
+    // Total wall time, for fixed depth benches this is the sum of the times to depth of all the positions
+    uint64_t time = 0;
+};
+
+// Searches all the bench positions with the given settings, a movetime of 0 means the search is depth limited
+static BenchResult RunBench(const int depth, const int threadCount, const int hash, const int movetime) {
     UciOptions uciOptions;
+    uciOptions.Threads = threadCount;
+    uciOptions.Hash = hash;
     ThreadData* td(new ThreadData());
-    uint64_t totalNodes = 0;
-    InitTT(64);
-    InitNewGame(td);
-    auto start = std::chrono::steady_clock::now();
-    for (int positions = 0; positions < 51; positions++) {
+    BenchResult result;
+    InitTT(hash, threadCount);
+    InitNewGame(td, threadCount);
+    for (int positions = 0; positions < BENCH_POSITION_COUNT; positions++) {
         ParseFen(benchmarkfens[positions], &td->pos);
-        td->keyHistory.clear();
         std::cout << "\nPosition: " << positions + 1 << " fen: " << benchmarkfens[positions] << std::endl;
-        RootSearch(depth, td, &uciOptions);
-        totalNodes += td->info.nodes;
+        td->info.Reset();
+        td->info.starttime = td->info.tmStartTime = GetTimeMs();
+        if (movetime) {
+            td->info.movetimeset = true;
+            Optimum(&td->info, movetime, 0);
+        }
+        const auto start = std::chrono::steady_clock::now();
+        RootSearch(movetime ? MAXDEPTH : depth, td, &uciOptions);
+        const auto end = std::chrono::steady_clock::now();
+        result.time += std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
+        result.nodes += td->info.nodes + GetTotalNodes();
     }
-    auto end = std::chrono::steady_clock::now();
-    auto totalTime = std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count();
-    std::cout << "\n";
-    std::cout << totalNodes << " nodes " << signed(totalNodes / (totalTime + 1) * 1000) << " nps" << std::endl;
     delete td;
+    return result;
+}
+
+void StartBench(int depth, int threadCount, int hash, int movetime) {
+    // Multithreaded benches are compared against a single threaded run with the same settings
+    BenchResult baseline;
+    if (threadCount > 1)
+        baseline = RunBench(depth, 1, hash, movetime);
+
+    const BenchResult result = RunBench(depth, threadCount, hash, movetime);
+    const uint64_t nps = result.nodes / (result.time + 1) * 1000;
+    std::cout << "\n";
+
+    if (threadCount > 1) {
+        const uint64_t baselineNps = baseline.nodes / (baseline.time + 1) * 1000;
+        std::cout << "Threads                 " << 1 << " / " << threadCount << "\n";
+        std::cout << "Nodes                   " << baseline.nodes << " / " << result.nodes << "\n";
+        std::cout << "Time (ms)               " << baseline.time << " / " << result.time << "\n";
+        std::cout << "NPS                     " << baselineNps << " / " << nps << "\n";
+        std::cout << "NPS per thread          " << baselineNps << " / " << nps / threadCount << "\n";
+        std::cout << "NPS speedup             " << static_cast<double>(nps) / static_cast<double>(baselineNps + !baselineNps) << "\n";
+        // With a fixed movetime every run takes the same time, so only a depth limited bench can measure the time to depth
+        if (!movetime)
+            std::cout << "Time to depth speedup   " << static_cast<double>(baseline.time) / static_cast<double>(result.time + !result.time) << "\n";
+    }
+    std::cout << result.nodes << " nodes " << signed(nps) << " nps" << std::endl;
 }
@@ -1,4 +1,11 @@
 #pragma once
 
-// starts a bench for alexandria, searching a set of positions up to a set depth
-void StartBench(int depth = 14);
+// Number of positions the bench searches
+constexpr int BENCH_POSITION_COUNT = 51;
+
+// The bench positions, also used by movebench
+extern const char* benchmarkfens[52];
+
+// starts a bench for alexandria, searching a set of positions up to a set depth (or for movetime ms per position if movetime isn't 0)
+// when using more than 1 thread the results are compared against a single threaded run with the same settings
+void StartBench(int depth = 14, int threadCount = 1, int hash = 64, int movetime = 0);
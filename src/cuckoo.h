@@ -3,8 +3,9 @@
 #include <cstdint>
 #include "types.h"
 
-inline std::array<uint64_t, 8192> keys{};
-inline std::array<Move, 8192> cuckooMoves{};
+// Keys and moves of the reversible moves of every piece, generated at compile time in init.cpp
+extern const std::array<uint64_t, 8192> keys;
+extern const std::array<Move, 8192> cuckooMoves;
 
 constexpr auto H1(uint64_t key)
 {
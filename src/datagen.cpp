@@ -0,0 +1,180 @@
+#include "datagen.h"
+#include "makemove.h"
+#include "misc.h"
+#include "movegen.h"
+#include "random.h"
+#include "search.h"
+#include "threads.h"
+#include "ttable.h"
+#include "uci.h"
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Every game starts with this many random moves, plus one half of the time so that both sides get to play first out of book
+constexpr int RANDOM_PLIES = 8;
+// Openings that an engine search already judges as this lopsided are thrown away
+constexpr int MAX_OPENING_SCORE = 1000;
+// A game is adjudicated as won once the score stays above this for WIN_ADJ_PLIES plies in a row
+constexpr int WIN_ADJ_SCORE = 2500;
+constexpr int WIN_ADJ_PLIES = 4;
+// A game is adjudicated as drawn once the score stays inside this window for DRAW_ADJ_PLIES plies in a row past DRAW_ADJ_START
+constexpr int DRAW_ADJ_SCORE = 20;
+constexpr int DRAW_ADJ_PLIES = 12;
+constexpr int DRAW_ADJ_START = 80;
+// Games that get this long are called a draw
+constexpr int MAX_GAME_PLIES = 800;
+// Size of the TT of each datagen thread
+constexpr uint64_t DATAGEN_HASH_MB = 16;
+
+// State shared by all the datagen threads
+struct DatagenState {
+    std::atomic<int> gamesStarted = 0;
+    std::atomic<int> gamesDone = 0;
+    std::atomic<uint64_t> positions = 0;
+    std::mutex fileMutex;
+    std::ofstream file;
+    uint64_t starttime = 0;
+};
+
+static PackedPosition PackPosition(const Position* pos, const int score) {
+    PackedPosition packed = {};
+    int count = 0;
+    for (int square = 0; square < 64; square++) {
+        // Our squares start from a8, the packed ones from a1
+        const int piece = pos->PieceOn(square ^ 56);
+        if (piece == EMPTY)
+            continue;
+        packed.occupancy |= 1ULL << square;
+        packed.pieces[count / 2] |= ((piece % 6) | (piece / 6) << 3) << (4 * (count % 2));
+        count++;
+    }
+    packed.score = static_cast<int16_t>(pos->side == WHITE ? score : -score);
+    packed.sideToMove = static_cast<uint8_t>(pos->side);
+    packed.epSquare = static_cast<uint8_t>(pos->getEpSquare() == no_sq ? 64 : pos->getEpSquare() ^ 56);
+    packed.castlePerm = static_cast<uint8_t>(pos->getCastlingPerm());
+    packed.fiftyMove = static_cast<uint8_t>(std::min(pos->get50MrCounter(), 255));
+    return packed;
+}
+
+// Runs a search limited to the given number of nodes, returns the score from the point of view of the side to move
+static int SearchNodes(ThreadData* td, UciOptions* options, const int nodes) {
+    td->info.Reset();
+    td->info.nodeset = true;
+    td->info.nodeslimit = nodes;
+    td->info.depth = MAXDEPTH;
+    td->info.starttime = td->info.tmStartTime = GetTimeMs();
+    SearchPosition(1, MAXDEPTH, td, options);
+    return td->completedScore;
+}
+
+// Plays random moves from the start position, returns false if the game ended in the process or the resulting position is too unbalanced
+static bool PlayRandomOpening(ThreadData* td, UciOptions* options, const int nodes, uint64_t& seed) {
+    Position* pos = &td->pos;
+    ParseFen(start_position, pos);
+    const int randomPlies = RANDOM_PLIES + static_cast<int>(GetRandomU64Number(seed) % 2);
+    for (int ply = 0; ply < randomPlies; ply++) {
+        MoveList legalMoves;
+        GenerateLegalMoves(&legalMoves, pos);
+        if (legalMoves.count == 0)
+            return false;
+        const Move move = legalMoves.moves[GetRandomU64Number(seed) % legalMoves.count];
+        MakeMove<false>(move, pos);
+    }
+    MoveList legalMoves;
+    GenerateLegalMoves(&legalMoves, pos);
+    return legalMoves.count && std::abs(SearchNodes(td, options, nodes)) <= MAX_OPENING_SCORE;
+}
+
+// Plays a game from the current position until it's over or adjudicated, filling the list with the positions worth keeping, returns the result from white's point of view
+static uint8_t PlayGame(ThreadData* td, UciOptions* options, const int nodes, std::vector<PackedPosition>& gamePositions) {
+    Position* pos = &td->pos;
+    int winPlies = 0;
+    int drawPlies = 0;
+    for (int ply = 0; ply < MAX_GAME_PLIES; ply++) {
+        MoveList legalMoves;
+        GenerateLegalMoves(&legalMoves, pos);
+        // Checkmate or stalemate
+        if (legalMoves.count == 0)
+            return pos->getCheckers() ? (pos->side == WHITE ? 0 : 2) : 1;
+
+        if (IsDraw(pos))
+            return 1;
+
+        const int score = SearchNodes(td, options, nodes);
+        const Move move = GetBestMove(td);
+        const int whiteScore = pos->side == WHITE ? score : -score;
+
+        // Adjudicate decided and dead drawn games
+        winPlies = std::abs(score) >= WIN_ADJ_SCORE ? winPlies + 1 : 0;
+        if (winPlies >= WIN_ADJ_PLIES)
+            return whiteScore > 0 ? 2 : 0;
+        drawPlies = ply >= DRAW_ADJ_START && std::abs(score) <= DRAW_ADJ_SCORE ? drawPlies + 1 : 0;
+        if (drawPlies >= DRAW_ADJ_PLIES)
+            return 1;
+
+        // Positions in check, with a tactical best move or with a mate score are too noisy to train on
+        if (   !pos->getCheckers()
+            && !isTactical(move)
+            && std::abs(score) < MATE_FOUND)
+            gamePositions.push_back(PackPosition(pos, score));
+
+        MakeMove<false>(move, pos);
+    }
+    return 1;
+}
+
+// Plays games on its own ThreadData and TT until all the games have been started, writing each finished game to the output file
+static void DatagenWorker(const int workerId, const int games, const int nodes, DatagenState* state) {
+    StandaloneThread thread(DATAGEN_HASH_MB);
+    ThreadData* td = thread.td.get();
+    UciOptions options;
+    uint64_t seed = (GetTimeMs() << 16) ^ (0x9E3779B97F4A7C15ULL * (workerId + 1));
+    std::vector<PackedPosition> gamePositions;
+
+    while (state->gamesStarted++ < games) {
+        ClearTT(1, &thread.table);
+        while (!PlayRandomOpening(td, &options, nodes, seed))
+            ;
+        gamePositions.clear();
+        const uint8_t result = PlayGame(td, &options, nodes, gamePositions);
+        for (auto& position : gamePositions)
+            position.result = result;
+
+        std::lock_guard<std::mutex> lock(state->fileMutex);
+        state->file.write(reinterpret_cast<const char*>(gamePositions.data()), static_cast<std::streamsize>(gamePositions.size() * sizeof(PackedPosition)));
+        state->positions += gamePositions.size();
+        const int gamesDone = ++state->gamesDone;
+        if (gamesDone % 10 == 0 || gamesDone == games) {
+            const uint64_t time = GetTimeMs() - state->starttime;
+            std::cout << "games " << gamesDone << "/" << games << " positions " << state->positions
+                      << " positions/s " << state->positions * 1000 / (time + 1) << std::endl;
+        }
+    }
+}
+
+void StartDatagen(int threadCount, int games, int nodes, const std::string& fileName) {
+    DatagenState state;
+    state.file.open(fileName, std::ios::binary | std::ios::app);
+    if (!state.file) {
+        std::cout << "Could not open " << fileName << std::endl;
+        return;
+    }
+    state.starttime = GetTimeMs();
+
+    // The search output would just slow us down
+    const bool oldTryhardmode = tryhardmode;
+    tryhardmode = true;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threadCount; i++)
+        workers.emplace_back(DatagenWorker, i, games, nodes, &state);
+    for (auto& worker : workers)
+        worker.join();
+
+    tryhardmode = oldTryhardmode;
+    std::cout << "Wrote " << state.positions << " positions to " << fileName << std::endl;
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+// A position as stored by datagen, 32 bytes per position
+struct PackedPosition {
+    // occupied squares, a1 is bit 0 and h8 is bit 63
+    uint64_t occupancy;
+    // one nibble per occupied square in the order of occupancy, low nibble first: piece type (pawn = 0, king = 5) | color << 3 (white = 0)
+    uint8_t pieces[16];
+    // search score from white's point of view
+    int16_t score;
+    // game result from white's point of view: 0 is a loss, 1 a draw and 2 a win
+    uint8_t result;
+    uint8_t sideToMove;
+    // en passant square with a1 = 0, 64 if there's none
+    uint8_t epSquare;
+    uint8_t castlePerm;
+    uint8_t fiftyMove;
+    uint8_t padding;
+};
+
+static_assert(sizeof(PackedPosition) == 32);
+
+// Plays games of the engine against itself on threadCount threads, searching nodes nodes per move, and appends the positions to the given file
+void StartDatagen(int threadCount, int games, int nodes, const std::string& fileName);
@@ -28,8 +28,8 @@ int pawnhistory_malus(const int depth);
 // Getters for the history heuristics
 [[nodiscard]] int GetHHScore(const Position* pos, const SearchData* sd, const Move move);
 [[nodiscard]] int GetRHScore(const Position* pos, const SearchData* sd, const Move move);
-[[nodiscard]] int GetCHScore(const SearchStack* ss, const Move move);
-[[nodiscard]] int GetSingleCHScore(const SearchStack* ss, const Move move, const int offset);
+[[nodiscard]] int GetCHScore(const SearchStack* ss, const int piece, const Move move);
+[[nodiscard]] int GetSingleCHScore(const SearchStack* ss, const int piece, const Move move, const int offset);
 [[nodiscard]] int GetCapthistScore(const Position* pos, const SearchData* sd, const Move move);
 [[nodiscard]] int GetPawnHistScore(const Position* pos, const SearchData* sd, const Move move);
 [[nodiscard]] int GetHistoryScore(const Position* pos, const SearchData* sd, const Move move, const SearchStack* ss, const bool rootNode);
@@ -40,9 +40,9 @@ void CleanHistories(SearchData* sd);
 // Updates history heuristics for a single move
 void updateHHScore(const Position* pos, SearchData* sd, const Move move, int bonus);
 void updateOppHHScore(const Position* pos, SearchData* sd, const Move move, int bonus);
-void updateCHScore(SearchStack* ss, const Move move, const int bonus);
+void updateCHScore(SearchStack* ss, const int piece, const Move move, const int bonus);
 void updateCapthistScore(const Position* pos, SearchData* sd, const Move move, int bonus);
-void updateSingleCHScore(SearchStack* ss, const Move move, const int bonus, const int offset);
+void updateSingleCHScore(SearchStack* ss, const int piece, const Move move, const int bonus, const int offset);
 void updatePawnHistScore(const Position* pos, SearchData* sd, const Move move, int bonus);
 
 // Corrhist stuff
@@ -14,64 +14,113 @@
 #include <windows.h>
 #endif
 
+// Lays out the tables of the squares of a slider one after the other, starting at firstOffset
+[[nodiscard]] static constexpr std::array<SliderMagic, 64> GenerateSliderMagics(const bool bishop, uint32_t firstOffset) {
+    std::array<SliderMagic, 64> magics{};
+    uint32_t offset = firstOffset;
+    for (int square = 0; square < 64; square++) {
+        const Bitboard mask = bishop ? MaskBishopAttacks(square) : MaskRookAttacks(square);
+        const int bits = CountBits(mask);
+        magics[square] = { mask, bishop ? bishop_magic_numbers[square] : rook_magic_numbers[square], offset, static_cast<uint32_t>(64 - bits) };
+        offset += 1U << bits;
+    }
+    return magics;
+}
+
+// Builds a table with an entry per square out of one of the attack generators
+template <typename Generator>
+[[nodiscard]] static constexpr std::array<Bitboard, 64> GenerateSquareTable(Generator generator) {
+    std::array<Bitboard, 64> table{};
+    for (int square = 0; square < 64; square++)
+        table[square] = generator(square);
+    return table;
+}
+
 // pawn attacks table [side][square]
-Bitboard pawn_attacks[2][64];
+constexpr std::array<std::array<Bitboard, 64>, 2> pawn_attacks = {
+    GenerateSquareTable([](int square) { return MaskPawnAttacks(WHITE, square); }),
+    GenerateSquareTable([](int square) { return MaskPawnAttacks(BLACK, square); })
+};
 
 // knight attacks table [square]
-Bitboard knight_attacks[64];
+constexpr std::array<Bitboard, 64> knight_attacks = GenerateSquareTable(MaskKnightAttacks);
 
 // king attacks table [square]
-Bitboard king_attacks[64];
-
-// bishop attack masks
-Bitboard bishop_masks[64];
+constexpr std::array<Bitboard, 64> king_attacks = GenerateSquareTable(MaskKingAttacks);
 
-// rook attack masks
-Bitboard rook_masks[64];
+// bishop masks, magics and table offsets [square]
+constexpr std::array<SliderMagic, 64> bishop_magics = GenerateSliderMagics(true, 0);
 
-// bishop attacks table [square][pos->occupancies]
-Bitboard bishop_attacks[64][512];
+// rook masks, magics and table offsets [square]
+constexpr std::array<SliderMagic, 64> rook_magics = GenerateSliderMagics(false, BISHOP_TABLE_SIZE);
 
-// rook attacks rable [square][pos->occupancies]
-Bitboard rook_attacks[64][4096];
+static_assert(bishop_magics[63].offset + (1U << (64 - bishop_magics[63].shift)) == BISHOP_TABLE_SIZE);
+static_assert(rook_magics[63].offset + (1U << (64 - rook_magics[63].shift)) == SLIDER_TABLE_SIZE);
 
-Bitboard SQUARES_BETWEEN_BB[64][64];
-
-// Initialize the Zobrist keys
-void initHashKeys() {
-    for (int Typeindex = WP; Typeindex <= BK; ++Typeindex) {
-        for (int squareIndex = 0; squareIndex < 64; ++squareIndex) {
-            PieceKeys[Typeindex][squareIndex] = GetRandomU64Number();
+// Fills the attacks of every square of a slider for every occupancy of the squares that can block it, at the index getBishopAttacks/getRookAttacks look them up at
+static constexpr void FillSliderAttacks(std::array<Bitboard, SLIDER_TABLE_SIZE>& table, const std::array<SliderMagic, 64>& magics, const bool bishop) {
+    for (int square = 0; square < 64; square++) {
+        const SliderMagic& entry = magics[square];
+        // Walk all the subsets of the mask, they come in the same order _pext_u64 numbers them in
+        const uint64_t subsets = 1ULL << CountBits(entry.mask);
+        Bitboard occupancy = 0ULL;
+        for (uint64_t subset = 0; subset < subsets; subset++) {
+#if defined (USE_PEXT)
+            const uint64_t attack_index = entry.offset + subset;
+#else
+            const uint64_t attack_index = entry.offset + ((occupancy * entry.magic) >> entry.shift);
+#endif
+            table[attack_index] = bishop ? BishopAttacksOnTheFly(square, occupancy) : RookAttacksOnTheFly(square, occupancy);
+            occupancy = (occupancy - entry.mask) & entry.mask;
         }
     }
-    // loop over board squares
-    for (int square = 0; square < 64; square++)
-        // init random enpassant keys
-        enpassant_keys[square] = GetRandomU64Number();
+}
+
+[[nodiscard]] static constexpr std::array<Bitboard, SLIDER_TABLE_SIZE> GenerateSliderAttacks() {
+    std::array<Bitboard, SLIDER_TABLE_SIZE> table{};
+    FillSliderAttacks(table, bishop_magics, true);
+    FillSliderAttacks(table, rook_magics, false);
+    return table;
+}
 
-    // loop over castling keys
-    for (int index = 0; index < 16; index++)
-        // init castling keys
-        CastleKeys[index] = GetRandomU64Number();
+// bishop and rook attacks table [offset of the square + occupancy index]
+constexpr std::array<Bitboard, SLIDER_TABLE_SIZE> slider_attacks = GenerateSliderAttacks();
 
-    // init random side key
-    SideKey = GetRandomU64Number();
+// Squares between 2 squares on the same line (rank, file or diagonal) [square][square]
+[[nodiscard]] static constexpr std::array<std::array<Bitboard, 64>, 64> GenerateSquaresBetween() {
+    std::array<std::array<Bitboard, 64>, 64> table{};
+    for (int sq1 = 0; sq1 < 64; ++sq1) {
+        for (int sq2 = 0; sq2 < 64; ++sq2) {
+            const Bitboard sqs = (1ULL << sq1) | (1ULL << sq2);
+            if (get_file[sq1] == get_file[sq2] || get_rank[sq1] == get_rank[sq2])
+                table[sq1][sq2] = RookAttacksOnTheFly(sq1, sqs) & RookAttacksOnTheFly(sq2, sqs);
+            else if (get_diagonal[sq1] == get_diagonal[sq2] || get_antidiagonal(sq1) == get_antidiagonal(sq2))
+                table[sq1][sq2] = BishopAttacksOnTheFly(sq1, sqs) & BishopAttacksOnTheFly(sq2, sqs);
+        }
+    }
+    return table;
 }
 
-void initializeLookupTables() {
-    // initialize squares between table
-    Bitboard sqs;
+// Whole line going through 2 different squares [square][square]
+[[nodiscard]] static constexpr std::array<std::array<Bitboard, 64>, 64> GenerateLines() {
+    std::array<std::array<Bitboard, 64>, 64> table{};
     for (int sq1 = 0; sq1 < 64; ++sq1) {
         for (int sq2 = 0; sq2 < 64; ++sq2) {
-            sqs = (1ULL << sq1) | (1ULL << sq2);
+            const Bitboard sqs = (1ULL << sq1) | (1ULL << sq2);
+            if (sq1 == sq2)
+                continue;
             if (get_file[sq1] == get_file[sq2] || get_rank[sq1] == get_rank[sq2])
-                SQUARES_BETWEEN_BB[sq1][sq2] = getRookAttacks(sq1, sqs) & getRookAttacks(sq2, sqs);
+                table[sq1][sq2] = (RookAttacksOnTheFly(sq1, 0ULL) & RookAttacksOnTheFly(sq2, 0ULL)) | sqs;
             else if (get_diagonal[sq1] == get_diagonal[sq2] || get_antidiagonal(sq1) == get_antidiagonal(sq2))
-                SQUARES_BETWEEN_BB[sq1][sq2] = getBishopAttacks(sq1, sqs) & getBishopAttacks(sq2, sqs);
+                table[sq1][sq2] = (BishopAttacksOnTheFly(sq1, 0ULL) & BishopAttacksOnTheFly(sq2, 0ULL)) | sqs;
         }
     }
+    return table;
 }
 
+constexpr std::array<std::array<Bitboard, 64>, 64> SQUARES_BETWEEN_BB = GenerateSquaresBetween();
+constexpr std::array<std::array<Bitboard, 64>, 64> LINE_BB = GenerateLines();
+
 // PreCalculate the logarithms used in the reduction calculation
 void InitReductions() {
     // Avoid log(0) because it's bad
@@ -91,12 +140,33 @@ void InitReductions() {
     }
 }
 
-void initCuckoo(){
+// Attacks of a piece that isn't a pawn on an empty board
+[[nodiscard]] static constexpr Bitboard EmptyBoardAttacks(const int piecetype, const int square) {
+    switch (piecetype) {
+        case KNIGHT:
+            return MaskKnightAttacks(square);
+        case BISHOP:
+            return BishopAttacksOnTheFly(square, 0ULL);
+        case ROOK:
+            return RookAttacksOnTheFly(square, 0ULL);
+        case QUEEN:
+            return BishopAttacksOnTheFly(square, 0ULL) | RookAttacksOnTheFly(square, 0ULL);
+        default:
+            return MaskKingAttacks(square);
+    }
+}
+
+struct CuckooTables {
+    std::array<uint64_t, 8192> keys;
+    std::array<Move, 8192> moves;
+};
+
+[[nodiscard]] static constexpr CuckooTables GenerateCuckooTables() {
     // keep a total tally of the table entries to sanity check the init
     int count = 0;
-    // Reset any previously initialized value
-    keys.fill(0);
-    cuckooMoves.fill(NOMOVE);
+    CuckooTables tables{};
+    tables.keys.fill(0);
+    tables.moves.fill(NOMOVE);
 
     for(int piece = WN; piece <= BK; piece++) {
         if (piece == BP) continue;
@@ -104,16 +174,16 @@ void initCuckoo(){
             for (int square1 = square0 + 1; square1 < 64; square1++) {
 
                 // check if a piece of piecetype standing on square0 could attack square1
-                const Bitboard possibleattackoverlapthing = pieceAttacks(GetPieceType(piece), square0, 0) & (1ULL << square1);
+                const Bitboard possibleattackoverlapthing = EmptyBoardAttacks(PieceType[piece], square0) & (1ULL << square1);
                 if (possibleattackoverlapthing == 0ULL)
                     continue;
-                Move move = encode_move(square0,square1,PAWN,Movetype::Quiet);
+                Move move = encode_move(square0,square1, Movetype::Quiet);
                 ZobristKey key = PieceKeys[piece][square0] ^ PieceKeys[piece][square1] ^ SideKey;
                 uint32_t slot = H1(key);
                 while (true)
                 {
-                    std::swap(keys[slot], key);
-                    std::swap(cuckooMoves[slot], move);
+                    std::swap(tables.keys[slot], key);
+                    std::swap(tables.moves[slot], move);
 
                     if (move == NOMOVE)
                         break;
@@ -125,8 +195,12 @@ void initCuckoo(){
         }
     }
     assert(count == 3668);
+    return tables;
 }
 
+constexpr std::array<uint64_t, 8192> keys = GenerateCuckooTables().keys;
+constexpr std::array<Move, 8192> cuckooMoves = GenerateCuckooTables().moves;
+
 void InitAll() {
     // Force windows to display colors
 #ifdef _WIN64
@@ -137,52 +211,62 @@ void InitAll() {
         SetConsoleMode(stdoutHandle, flags | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
     }
 #endif
-    // init attacks tables
-    InitAttackTables();
-    initializeLookupTables();
-    initHashKeys();
     InitReductions();
     // Init TT
     InitTT(16);
     NNUE::init();
-    initCuckoo();
 }
 
-void InitNewGame(ThreadData* td) {
+// Resets all the data a single thread accumulated during the previous games
+static void ClearThreadData(ThreadData* td) {
+    td->resetFinnyTable();
+    CleanHistories(&td->sd);
+    std::memset(td->sd.counterMoves, NOMOVE, sizeof(td->sd.counterMoves));
+    std::memset(td->sd.counterPieces, 0, sizeof(td->sd.counterPieces));
+}
+
+void InitNewGame(ThreadData* td, const int threadCount) {
     // Extract data structures from ThreadData
     Position* pos = &td->pos;
-    SearchData* sd = &td->sd;
     SearchInfo* info = &td->info;
 
-    td->resetFinnyTable();
+    // Make sure no helper is still searching and that every helper has its own thread_data, so they are kept for the next search
+    StopHelperThreads();
+    ResizeThreadsData(threadCount);
 
-    CleanHistories(sd);
+    // Dispatch the reset to the helper threads: each one cleans its own search data and a slice of the TT in parallel
+    for (auto& helper : threads_data)
+        threads.emplace_back([&helper, threadCount] {
+            ClearThreadData(&helper);
+            ClearTTSlice(helper.id, threadCount);
+        });
+
+    // Meanwhile the main thread does the same with its own data and the first slice of the TT
+    ClearThreadData(td);
+    ClearTTSlice(0, threadCount);
 
     // Clean the PV Table
     for (int index = 0; index < MAXDEPTH + 1; ++index) {
-        pvTable.pvLength[index] = 0;
+        td->pvTable.pvLength[index] = 0;
         for (int index2 = 0; index2 < MAXDEPTH + 1; ++index2) {
-            pvTable.pvArray[index][index2] = NOMOVE;
+            td->pvTable.pvArray[index][index2] = NOMOVE;
         }
     }
 
-    std::memset(sd->counterMoves, NOMOVE, sizeof(sd->counterMoves));
-
     // Reset plies and search info
     info->starttime = GetTimeMs();
     info->stopped = 0;
     info->nodes = 0;
     info->seldepth = 0;
-    // Clear TT
-    ClearTT();
-
-    // Empty threads and thread data
-    StopHelperThreads();
 
-    threads_data.clear();
+    // Wait for the helpers to be done
+    for (auto& th : threads)
+        th.join();
+    threads.clear();
+    TT.age = 1;
+    // The TT is empty so there's nothing to resume an analysis from
+    lastSearch.depth = 0;
 
-    // delete played moves hashes
-    td->keyHistory.clear();
     // call parse position function
-    ParsePosition("position startpos", pos, td->keyHistory);
+    ParsePosition("position startpos", pos);
 }
@@ -1,19 +1,44 @@
 #pragma once
 
+#include "random.h"
 #include "types.h"
 
 struct Position;
 struct ThreadData;
 
-inline Bitboard PieceKeys[12][64];
-inline Bitboard enpassant_keys[64];
-inline Bitboard SideKey;
-inline Bitboard CastleKeys[16];
+struct ZobristKeys {
+    Bitboard pieceKeys[12][64];
+    Bitboard enpassantKeys[64];
+    Bitboard castleKeys[16];
+    Bitboard sideKey;
+};
 
-void InitNewGame(ThreadData* td);
+// Draws the Zobrist keys from the xorshift generator, always starting from the same seed so the keys never change between builds
+[[nodiscard]] constexpr ZobristKeys GenerateZobristKeys() {
+    ZobristKeys zobrist{};
+    uint64_t state = 6379633040001738036ULL;
+    for (int Typeindex = WP; Typeindex <= BK; ++Typeindex)
+        for (int squareIndex = 0; squareIndex < 64; ++squareIndex)
+            zobrist.pieceKeys[Typeindex][squareIndex] = GetRandomU64Number(state);
 
-// init slider piece's attack tables
-void InitAttackTables();
+    for (int square = 0; square < 64; square++)
+        zobrist.enpassantKeys[square] = GetRandomU64Number(state);
+
+    for (int index = 0; index < 16; index++)
+        zobrist.castleKeys[index] = GetRandomU64Number(state);
+
+    zobrist.sideKey = GetRandomU64Number(state);
+    return zobrist;
+}
+
+inline constexpr ZobristKeys zobristKeys = GenerateZobristKeys();
+inline constexpr auto& PieceKeys = zobristKeys.pieceKeys;
+inline constexpr auto& enpassant_keys = zobristKeys.enpassantKeys;
+inline constexpr auto& CastleKeys = zobristKeys.castleKeys;
+inline constexpr Bitboard SideKey = zobristKeys.sideKey;
+
+// Resets the engine state to start a new game, the work is split among threadCount threads
+void InitNewGame(ThreadData* td, const int threadCount = 1);
 
 void InitAll();
 // has to be exposed for tuning refreshes
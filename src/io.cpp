@@ -132,7 +132,7 @@ void PrintMove(const Move move) {
 }
 
 char* FormatMove(const Move move) {
-    static char moveString[6];
+    static thread_local char moveString[6];
     const char* from = square_to_coordinates[From(move)];
     const char* to = square_to_coordinates[To(move)];
 
@@ -146,8 +146,8 @@ char* FormatMove(const Move move) {
 
 void PrintMoveList(const MoveList* list) {
     for (int index = 0; index < list->count; ++index) {
-        Move move = list->moves[index].move;
-        int score = list->moves[index].score;
+        Move move = list->moves[index];
+        int score = list->scores[index];
         std::cout << "Move " << index + 1 << " : " << FormatMove(move) << " score: " << score << std::endl;
     }
     std::cout << "Total Moves: " << list->count << "\n";
@@ -166,10 +166,12 @@ std::string Pick_color(int score) {
 }
 
 // Prints the uci output
-void PrintUciOutput(const int score, const int depth, const ThreadData* td, const UciOptions* options) {
+void PrintUciOutput(const int score, const int depth, const ThreadData* td, const int multiPV, const PvLine* line) {
     // We are benching the engine and we don't care about the output
     if (tryhardmode)
         return;
+    const Move* pv = line ? line->moves : td->pvTable.pvArray[0];
+    const int pvLength = line ? line->length : td->pvTable.pvLength[0];
     // This handles the basic console output
     long time = GetTimeMs() - td->info.starttime;
     uint64_t nodes = td->info.nodes + GetTotalNodes();
@@ -177,21 +179,21 @@ void PrintUciOutput(const int score, const int depth, const ThreadData* td, cons
     uint64_t nps = nodes / (time + !time) * 1000;
     if (print_uci) {
         if (score > -MATE_SCORE && score < -MATE_FOUND)
-            std::cout << "info score mate " << -(score + MATE_SCORE) / 2 << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << options->MultiPV << " nodes " << nodes <<
+            std::cout << "info score mate " << -(score + MATE_SCORE) / 2 << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << multiPV << " nodes " << nodes <<
             " nps " << nps << " time " << GetTimeMs() - td->info.starttime << " pv ";
 
         else if (score > MATE_FOUND && score < MATE_SCORE)
-            std::cout << "info score mate " << (MATE_SCORE - score) / 2 + 1 << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << options->MultiPV << " nodes " << nodes <<
+            std::cout << "info score mate " << (MATE_SCORE - score) / 2 + 1 << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << multiPV << " nodes " << nodes <<
             " nps " << nps << " time " << GetTimeMs() - td->info.starttime << " pv ";
 
         else
-            std::cout << "info score cp " << int(score / 2.5) << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << options->MultiPV << " nodes " << nodes <<
-            " nps " << nps << " hashfull "<< GetHashfull() << " time " << GetTimeMs() - td->info.starttime << " pv ";
+            std::cout << "info score cp " << int(score / 2.5) << " depth " << depth << " seldepth " << td->info.seldepth << " multipv " << multiPV << " nodes " << nodes <<
+            " nps " << nps << " hashfull "<< GetHashfull(td->tt) << " time " << GetTimeMs() - td->info.starttime << " pv ";
 
         // loop over the moves within a PV line
-        for (int count = 0; count < std::max(pvTable.pvLength[0], 1); count++) {
+        for (int count = 0; count < std::max(pvLength, 1); count++) {
             // print PV move
-            PrintMove(pvTable.pvArray[0][count]);
+            PrintMove(pv[count]);
             std::cout << " ";
         }
 
@@ -279,9 +281,9 @@ void PrintUciOutput(const int score, const int depth, const ThreadData* td, cons
         std::cout << std::setw(7) << std::right << std::fixed << static_cast<int>(nps / 1000.0) << "Kn/s" << " ";
 
         // loop over the moves within a PV line
-        for (int count = 0; count < std::max(pvTable.pvLength[0], 1); count++) {
+        for (int count = 0; count < std::max(pvLength, 1); count++) {
             // print PV move
-            PrintMove(pvTable.pvArray[0][count]);
+            PrintMove(pv[count]);
             std::cout << " ";
         }
 
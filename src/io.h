@@ -5,7 +5,7 @@
 struct Position;
 struct MoveList;
 struct ThreadData;
-struct UciOptions;
+struct PvLine;
 
 void printBitboard(const Bitboard bitboard);
 
@@ -23,4 +23,5 @@ void PrintMoveList(const MoveList* list);
 
 [[nodiscard]] char* FormatMove(const Move move);
 
-void PrintUciOutput(const int score, const int depth, const ThreadData* td, const UciOptions* options);
+// Prints the uci output for the given pv line, or for the pv table if no line is given
+void PrintUciOutput(const int score, const int depth, const ThreadData* td, const int multiPV = 1, const PvLine* line = nullptr);
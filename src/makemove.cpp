@@ -13,7 +13,7 @@ void inline HashKey(ZobristKey& originalKey , ZobristKey key) {
 void ClearPiece(const int piece, const int from, Position* pos) {
     assert(piece != EMPTY);
     const int color = Color[piece];
-    pop_bit(pos->state().bitboards[piece], from);
+    pop_bit(pos->state().pieceTypeBB[PieceType[piece]], from);
     pop_bit(pos->state().occupancies[color], from);
     pos->state().pieces[from] = EMPTY;
     HashKey(pos->state().posKey, PieceKeys[piece][from]);
@@ -28,7 +28,7 @@ void ClearPiece(const int piece, const int from, Position* pos) {
 void AddPiece(const int piece, const int to, Position* pos) {
     assert(piece != EMPTY);
     const int color = Color[piece];
-    set_bit(pos->state().bitboards[piece], to);
+    set_bit(pos->state().pieceTypeBB[PieceType[piece]], to);
     set_bit(pos->state().occupancies[color], to);
     pos->state().pieces[to] = piece;
     HashKey(pos->state().posKey, PieceKeys[piece][to]);
@@ -66,7 +66,7 @@ void MakeCastle(const Move move, Position* pos) {
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
     // Remove the piece fom the square it moved from
     ClearPiece(piece, sourceSquare, pos);
     // Set the piece to the destination square, if it was a promotion we directly set the promoted piece
@@ -108,7 +108,7 @@ void MakeEp(const Move move, Position* pos) {
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
     const int SOUTH = pos->side == WHITE ? 8 : -8;
 
     const int pieceCap = GetPiece(PAWN, pos->side ^ 1);
@@ -132,7 +132,7 @@ void MakePromo(const Move move, Position* pos, const bool capture) {
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
     const int promotedPiece = GetPiece(getPromotedPiecetype(move), pos->side);
     // Remove the piece fom the square it moved from
     ClearPiece(piece, sourceSquare, pos);
@@ -155,7 +155,7 @@ void MakeQuiet(const Move move, Position* pos) {
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
 
     // if a pawn was moved or a capture was played reset the 50 move rule counter
     if (GetPieceType(piece) == PAWN)
@@ -172,7 +172,7 @@ void MakeCapture(const Move move, Position* pos) {
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
 
     pos->state().fiftyMove = 0;
 
@@ -194,7 +194,7 @@ void MakeDP(const Move move, Position* pos)
     // parse move
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
 
     MovePiece(piece,sourceSquare,targetSquare, pos);
 
@@ -210,18 +210,22 @@ void MakeDP(const Move move, Position* pos)
     HashKey(pos->state().posKey, enpassant_keys[pos->getEpSquare()]);
 }
 
-template void MakeMove<true>(const Move move, Position* pos, std::vector<ZobristKey>& keyHistory);
-template void MakeMove<false>(const Move move, Position* pos, std::vector<ZobristKey>& keyHistory);
+template void MakeMove<true>(const Move move, Position* pos);
+template void MakeMove<false>(const Move move, Position* pos);
 
 // make move on chess board
 template <bool UPDATE>
-void MakeMove(const Move move, Position* pos, std::vector<ZobristKey>& keyHistory) {
+void MakeMove(const Move move, Position* pos) {
     if constexpr (UPDATE) {
         pos->history.push(pos->state());
     }
+    else {
+        // The state is changed in place, so the attack maps computed on it won't hold anymore
+        pos->attackMaps().valid = 0;
+    }
 
     // Store position key in the array of searched position
-    keyHistory.emplace_back(pos->getPoskey());
+    pos->keyHistory.push(pos->getPoskey());
 
     // parse move flag
     const bool capture = isCapture(move);
@@ -264,17 +268,19 @@ void MakeMove(const Move move, Position* pos, std::vector<ZobristKey>& keyHistor
     assert(pos->state().pawnKey == GeneratePawnKey(pos));
 }
 
-void UnmakeMove(Position* pos, std::vector<ZobristKey>& keyHistory) {
+void UnmakeMove(Position* pos) {
     pos->history.pop();
     pos->ChangeSide();
-    keyHistory.pop_back();
+    pos->keyHistory.pop();
 }
 
 // MakeNullMove handles the playing of a null move (a move that doesn't move any piece)
-void MakeNullMove(Position* pos, std::vector<ZobristKey>& keyHistory) {
+void MakeNullMove(Position* pos) {
     pos->history.push(pos->state());
+    // No piece moves, so the attack maps of the previous ply still hold
+    pos->attackMaps() = pos->history.attackMaps[pos->history.head - 1];
     // Store position key in the array of searched position
-    keyHistory.emplace_back(pos->getPoskey());
+    pos->keyHistory.push(pos->getPoskey());
     resetEpSquare(pos);
     pos->ChangeSide();
     HashKey(pos->state().posKey, SideKey);
@@ -289,8 +295,8 @@ void MakeNullMove(Position* pos, std::vector<ZobristKey>& keyHistory) {
 }
 
 // Take back a null move
-void TakeNullMove(Position* pos,  std::vector<ZobristKey>& keyHistory) {
+void TakeNullMove(Position* pos) {
     pos->history.pop();
     pos->ChangeSide();
-    keyHistory.pop_back();
+    pos->keyHistory.pop();
 }
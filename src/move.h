@@ -4,14 +4,10 @@
 
 struct Position;
 
-struct ScoredMove {
-    Move move;
-    int score;
-};
-
-// move list structure
+// move list structure, the scores are kept apart so that the moves stay 2 bytes each
 struct MoveList {
-    ScoredMove moves[256];
+    Move moves[256];
+    int scores[256];
     int count = 0;
 };
 
@@ -38,16 +34,15 @@ inline Movetype operator | (Movetype first, Movetype second){
     return static_cast<Movetype>((static_cast<int>(first) | static_cast<int>(second)));
 }
 
-inline Move encode_move(const int source, const int target, const int piece, const Movetype movetype) {
-    return (source) | (target << 6) | (static_cast<int>(movetype) << 12) | (piece << 16);
+constexpr Move encode_move(const int source, const int target, const Movetype movetype) {
+    return (source) | (target << 6) | (static_cast<int>(movetype) << 12);
 }
 
 inline Square From(const Move move) { return move & 0x3F; }
 inline Square To(const Move move) { return ((move & 0xFC0) >> 6); }
 inline unsigned int FromTo(const Move move) { return move & 0xFFF; }
-inline unsigned int Piece(const Move move) { return ((move & 0xF0000) >> 16); }
-inline unsigned int PieceTo(const Move move) { return (Piece(move) << 6) | To(move); }
-inline unsigned int PieceTypeTo(const Move move) { return (PieceType[Piece(move)] << 6) | To(move); }
+inline unsigned int PieceTo(const int piece, const Move move) { return (piece << 6) | To(move); }
+inline unsigned int PieceTypeTo(const int piece, const Move move) { return (PieceType[piece] << 6) | To(move); }
 inline unsigned int GetMovetype(const Move move) { return ((move & 0xF000) >> 12); }
 inline unsigned int getPromotedPiecetype(const Move move) { return (GetMovetype(move) & 3) + 1; }
 inline bool isEnpassant(const Move move) { return GetMovetype(move) == static_cast<int>(Movetype::enPassant); }
@@ -0,0 +1,176 @@
+#include "movebench.h"
+#include "bench.h"
+#include "makemove.h"
+#include "movegen.h"
+#include "position.h"
+#include "search.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+// Every function gets timed for at least this long, so that the timer resolution and the noise don't matter
+constexpr int64_t MIN_MEASURE_NS = 250'000'000;
+
+// A bench position along with the moves the functions get called on
+struct MoveBenchPosition {
+    std::unique_ptr<Position> pos;
+    // Pseudo legal moves of the position
+    MoveList moves;
+    MoveList legalMoves;
+    // The moves of the position followed by the ones of the next bench position, most of which aren't pseudo legal here,
+    // just like the TT moves and killers the search has to validate
+    std::vector<Move> candidates;
+};
+
+struct MoveBenchResult {
+    const char* name;
+    double nsPerCall;
+    uint64_t calls;
+};
+
+// Keeps the compiler from optimizing away the calls whose result we don't otherwise use
+static volatile uint64_t sink;
+
+// Runs pass over all the positions until enough time went by, pass returns the number of calls it made
+template <typename Pass>
+static MoveBenchResult Measure(const char* name, std::vector<MoveBenchPosition>& positions, Pass pass) {
+    uint64_t calls = 0;
+    uint64_t checksum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    int64_t elapsed;
+    do {
+        for (auto& position : positions) {
+            // The attack maps are cached per ply, a search never finds them already computed for a fresh node
+            position.pos->attackMaps().valid = 0;
+            calls += pass(position, checksum);
+        }
+        elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    } while (elapsed < MIN_MEASURE_NS);
+    sink = checksum;
+    return { name, static_cast<double>(elapsed) / static_cast<double>(calls), calls };
+}
+
+template <MovegenType type>
+static uint64_t GenerateMovesPass(MoveBenchPosition& position, uint64_t& checksum) {
+    MoveList moveList;
+    GenerateMoves(&moveList, position.pos.get(), type);
+    checksum += moveList.count;
+    return 1;
+}
+
+static uint64_t IsPseudoLegalPass(MoveBenchPosition& position, uint64_t& checksum) {
+    for (const Move move : position.candidates)
+        checksum += IsPseudoLegal(position.pos.get(), move);
+    return position.candidates.size();
+}
+
+static uint64_t IsLegalPass(MoveBenchPosition& position, uint64_t& checksum) {
+    for (int i = 0; i < position.moves.count; i++)
+        checksum += IsLegal(position.pos.get(), position.moves.moves[i]);
+    return position.moves.count;
+}
+
+static uint64_t MakeUnmakePass(MoveBenchPosition& position, uint64_t& checksum) {
+    for (int i = 0; i < position.legalMoves.count; i++) {
+        MakeMove<true>(position.legalMoves.moves[i], position.pos.get());
+        checksum += position.pos->getPoskey();
+        UnmakeMove(position.pos.get());
+    }
+    return position.legalMoves.count;
+}
+
+static uint64_t SEEPass(MoveBenchPosition& position, uint64_t& checksum) {
+    for (int i = 0; i < position.moves.count; i++)
+        checksum += SEE(position.pos.get(), position.moves.moves[i], 0);
+    return position.moves.count;
+}
+
+static uint64_t SEEScorePass(MoveBenchPosition& position, uint64_t& checksum) {
+    SEECache cache;
+    for (int i = 0; i < position.moves.count; i++)
+        checksum += SEEScore(position.pos.get(), position.moves.moves[i], &cache);
+    return position.moves.count;
+}
+
+static uint64_t UpdatePinsAndCheckersPass(MoveBenchPosition& position, uint64_t& checksum) {
+    UpdatePinsAndCheckers(position.pos.get());
+    checksum += position.pos->getCheckers() ^ position.pos->getPinnedMask(WHITE) ^ position.pos->getPinnedMask(BLACK);
+    return 1;
+}
+
+static uint64_t KeyAfterPass(MoveBenchPosition& position, uint64_t& checksum) {
+    for (int i = 0; i < position.moves.count; i++)
+        checksum += keyAfter(position.pos.get(), position.moves.moves[i]);
+    return position.moves.count;
+}
+
+void StartMoveBench(const std::string& format, const std::string& outputFile) {
+    std::vector<MoveBenchPosition> positions(BENCH_POSITION_COUNT);
+    for (int i = 0; i < BENCH_POSITION_COUNT; i++) {
+        positions[i].pos = std::make_unique<Position>();
+        ParseFen(benchmarkfens[i], positions[i].pos.get());
+        GenerateMoves(&positions[i].moves, positions[i].pos.get(), MOVEGEN_ALL);
+        GenerateLegalMoves(&positions[i].legalMoves, positions[i].pos.get());
+    }
+    for (int i = 0; i < BENCH_POSITION_COUNT; i++) {
+        const MoveList& next = positions[(i + 1) % BENCH_POSITION_COUNT].moves;
+        for (int j = 0; j < positions[i].moves.count; j++)
+            positions[i].candidates.push_back(positions[i].moves.moves[j]);
+        for (int j = 0; j < next.count; j++)
+            positions[i].candidates.push_back(next.moves[j]);
+    }
+
+    const MoveBenchResult results[] = {
+        Measure("GenerateMoves(noisy)", positions, GenerateMovesPass<MOVEGEN_NOISY>),
+        Measure("GenerateMoves(quiet)", positions, GenerateMovesPass<MOVEGEN_QUIET>),
+        Measure("GenerateMoves(all)", positions, GenerateMovesPass<MOVEGEN_ALL>),
+        Measure("IsPseudoLegal", positions, IsPseudoLegalPass),
+        Measure("IsLegal", positions, IsLegalPass),
+        Measure("MakeMove+UnmakeMove", positions, MakeUnmakePass),
+        Measure("SEE", positions, SEEPass),
+        Measure("SEEScore", positions, SEEScorePass),
+        Measure("UpdatePinsAndCheckers", positions, UpdatePinsAndCheckersPass),
+        Measure("keyAfter", positions, KeyAfterPass),
+    };
+
+    // CI reads the csv and json outputs from a file, as the engine also prints other things to stdout
+    std::ofstream file;
+    if (!outputFile.empty()) {
+        file.open(outputFile);
+        if (!file) {
+            std::cout << "Could not open " << outputFile << std::endl;
+            return;
+        }
+    }
+    std::ostream& out = outputFile.empty() ? std::cout : file;
+
+    char line[256];
+    if (format == "csv") {
+        out << "function,ns_per_call,calls\n";
+        for (const auto& result : results) {
+            snprintf(line, sizeof(line), "%s,%.2f,%llu\n", result.name, result.nsPerCall, static_cast<unsigned long long>(result.calls));
+            out << line;
+        }
+    }
+    else if (format == "json") {
+        out << "[\n";
+        for (size_t i = 0; i < std::size(results); i++) {
+            snprintf(line, sizeof(line), "  {\"function\": \"%s\", \"ns_per_call\": %.2f, \"calls\": %llu}%s\n",
+                results[i].name, results[i].nsPerCall, static_cast<unsigned long long>(results[i].calls), i + 1 < std::size(results) ? "," : "");
+            out << line;
+        }
+        out << "]\n";
+    }
+    else {
+        snprintf(line, sizeof(line), "%-24s %12s %14s\n", "function", "ns/call", "calls");
+        out << line;
+        for (const auto& result : results) {
+            snprintf(line, sizeof(line), "%-24s %12.2f %14llu\n", result.name, result.nsPerCall, static_cast<unsigned long long>(result.calls));
+            out << line;
+        }
+    }
+    out << std::flush;
+}
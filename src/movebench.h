@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Times the movegen and makemove hot paths over the bench positions and prints the ns per call of each of them,
+// format is one of "text", "csv" or "json", the results go to outputFile if one is given and to stdout otherwise
+void StartMoveBench(const std::string& format = "text", const std::string& outputFile = "");
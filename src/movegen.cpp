@@ -9,22 +9,38 @@
 
 // is the square given in input attacked by the current given side
 bool IsSquareAttacked(const Position* pos, const int square, const int side) {
+    // Computing the attack maps just for one square costs more than looking at the attackers, so only use them if they are already there,
+    // they see through the king of the other side but that only matters for squares behind it when it's in check
+    if (pos->attackMaps().valid & (1 << side))
+        return pos->attackMaps().all[side] & (1ULL << square);
     // Take the occupancies of both positions, encoding where all the pieces on the board reside
-    const Bitboard occ = pos->Occupancy(BOTH);
+    return IsSquareAttacked(pos, square, side, pos->Occupancy(BOTH));
+}
+
+// is the square the king of the other side wants to step on attacked by the given side, occ is the board without that king
+static inline bool IsKingSquareAttacked(const Position* pos, const int square, const int side, const Bitboard occ) {
+    // The attack maps already see through the king, but they are only worth it if somebody else already computed them
+    if (pos->attackMaps().valid & (1 << side))
+        return pos->attackMaps().all[side] & (1ULL << square);
+    return IsSquareAttacked(pos, square, side, occ);
+}
+
+// is the square given in input attacked by the current given side if the board was occupied by occ, pieces missing from occ don't attack
+bool IsSquareAttacked(const Position* pos, const int square, const int side, const Bitboard occ) {
     // is the square attacked by pawns
-    if (getPawnAttacks(square, side ^ 1) & pos->getPieceColorBB(PAWN, side))
+    if (getPawnAttacks(square, side ^ 1) & pos->getPieceColorBB(PAWN, side) & occ)
         return true;
     // is the square attacked by knights
-    if (getKnightAttacks(square) & pos->getPieceColorBB(KNIGHT, side))
+    if (getKnightAttacks(square) & pos->getPieceColorBB(KNIGHT, side) & occ)
         return true;
     // is the square attacked by kings
     if (getKingAttacks(square) & pos->getPieceColorBB(KING, side))
         return true;
     // is the square attacked by bishops
-    if (getBishopAttacks(square, occ) & (pos->getPieceColorBB(BISHOP, side) | pos->getPieceColorBB(QUEEN, side)))
+    if (getBishopAttacks(square, occ) & (pos->getPieceColorBB(BISHOP, side) | pos->getPieceColorBB(QUEEN, side)) & occ)
         return true;
     // is the square attacked by rooks
-    if (getRookAttacks(square, occ) & (pos->getPieceColorBB(ROOK, side) | pos->getPieceColorBB(QUEEN, side)))
+    if (getRookAttacks(square, occ) & (pos->getPieceColorBB(ROOK, side) | pos->getPieceColorBB(QUEEN, side)) & occ)
         return true;
     // by default return false
     return false;
@@ -33,11 +49,11 @@ bool IsSquareAttacked(const Position* pos, const int square, const int side) {
 // Check for move legality by generating the list of legal moves in a position and checking if that move is present
 bool MoveExists(Position* pos, const Move move) {
     MoveList list;
-    GenerateMoves(&list, pos, MOVEGEN_ALL);
+    GenerateLegalMoves(&list, pos);
 
     for (int moveNum = 0; moveNum < list.count; ++moveNum) {
-        if (list.moves[moveNum].move == move) {
-            return IsLegal(pos, move);
+        if (list.moves[moveNum] == move) {
+            return true;
         }
     }
     return false;
@@ -45,14 +61,14 @@ bool MoveExists(Position* pos, const Move move) {
 
 // function that adds a (not yet scored) move to a move list
 void AddMove(const Move move, MoveList* list) {
-    list->moves[list->count].move = move;
+    list->moves[list->count] = move;
     list->count++;
 }
 
 // function that adds an (already-scored) move to a move list
 void AddMove(const Move move, const int score, MoveList* list) {
-    list->moves[list->count].move = move;
-    list->moves[list->count].score = score;
+    list->moves[list->count] = move;
+    list->scores[list->count] = score;
     list->count++;
 }
 
@@ -60,66 +76,66 @@ static inline Bitboard NORTH(const Bitboard in, const int color) {
     return color == WHITE ? in >> 8 : in << 8;
 }
 
-static inline void PseudoLegalPawnMoves(Position* pos, int color, MoveList* list, MovegenType type) {
+// Generates the moves of the given pawns that land on targetMask, in legal mode en passant captures are checked separately since they can expose the king in unusual ways
+static inline void PawnMoves(Position* pos, int color, Bitboard ourPawns, Bitboard targetMask, MoveList* list, MovegenType type, bool legal) {
     const Bitboard enemy = pos->Occupancy(color ^ 1);
-    const Bitboard ourPawns = pos->getPieceColorBB(PAWN, color);
     const Bitboard rank4BB = color == WHITE ? 0x000000FF00000000ULL : 0x00000000FF000000ULL;
     const Bitboard freeSquares = ~pos->Occupancy(BOTH);
-    const int pawnType = GetPiece(PAWN, pos->side);
     const int north = color == WHITE ? -8 : 8;
     const bool genNoisy = type & MOVEGEN_NOISY;
     const bool genQuiet = type & MOVEGEN_QUIET;
 
     // Quiet moves (ie push/double-push)
     if (genQuiet) {
-        Bitboard push = NORTH(ourPawns, color) & freeSquares & ~0xFF000000000000FFULL;
-        Bitboard doublePush = NORTH(push, color) & freeSquares & rank4BB;
+        const Bitboard singlePush = NORTH(ourPawns, color) & freeSquares & ~0xFF000000000000FFULL;
+        Bitboard push = singlePush & targetMask;
+        Bitboard doublePush = NORTH(singlePush, color) & freeSquares & rank4BB & targetMask;
         while (push) {
             const int to = popLsb(push);
-            AddMove(encode_move(to - north, to, pawnType, Movetype::Quiet), list);
+            AddMove(encode_move(to - north, to, Movetype::Quiet), list);
         }
         while (doublePush) {
             const int to = popLsb(doublePush);
-            AddMove(encode_move(to - north * 2, to, pawnType, Movetype::doublePush), list);
+            AddMove(encode_move(to - north * 2, to, Movetype::doublePush), list);
         }
     }
 
     if (genNoisy) {
         // Push promotions
-        Bitboard pushPromo = NORTH(ourPawns, color) & freeSquares & 0xFF000000000000FFULL;
+        Bitboard pushPromo = NORTH(ourPawns, color) & freeSquares & 0xFF000000000000FFULL & targetMask;
         while (pushPromo) {
             const int to = popLsb(pushPromo);
-            AddMove(encode_move(to - north, to, pawnType, Movetype::queenPromo | Movetype::Quiet), list);
-            AddMove(encode_move(to - north, to, pawnType, Movetype::rookPromo | Movetype::Quiet), list);
-            AddMove(encode_move(to - north, to, pawnType, Movetype::bishopPromo | Movetype::Quiet), list);
-            AddMove(encode_move(to - north, to, pawnType, Movetype::knightPromo | Movetype::Quiet), list);
+            AddMove(encode_move(to - north, to, Movetype::queenPromo | Movetype::Quiet), list);
+            AddMove(encode_move(to - north, to, Movetype::rookPromo | Movetype::Quiet), list);
+            AddMove(encode_move(to - north, to, Movetype::bishopPromo | Movetype::Quiet), list);
+            AddMove(encode_move(to - north, to, Movetype::knightPromo | Movetype::Quiet), list);
         }
 
         // Captures and capture-promotions
-        Bitboard captBB1 = (NORTH(ourPawns, color) >> 1) & ~0x8080808080808080ULL & enemy;
-        Bitboard captBB2 = (NORTH(ourPawns, color) << 1) & ~0x101010101010101ULL & enemy;
+        Bitboard captBB1 = (NORTH(ourPawns, color) >> 1) & ~0x8080808080808080ULL & enemy & targetMask;
+        Bitboard captBB2 = (NORTH(ourPawns, color) << 1) & ~0x101010101010101ULL & enemy & targetMask;
         while (captBB1) {
             const int to = popLsb(captBB1);
             const int from = to - north + 1;
             if ((0xFF000000000000FFULL >> to) & 1) {
-                AddMove(encode_move(from, to, pawnType, (Movetype::queenPromo | Movetype::Capture)), list);
-                AddMove(encode_move(from, to, pawnType, (Movetype::rookPromo | Movetype::Capture)), list); 
-                AddMove(encode_move(from, to, pawnType, (Movetype::bishopPromo | Movetype::Capture)), list);
-                AddMove(encode_move(from, to, pawnType, (Movetype::knightPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::queenPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::rookPromo | Movetype::Capture)), list); 
+                AddMove(encode_move(from, to, (Movetype::bishopPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::knightPromo | Movetype::Capture)), list);
             }
-            else AddMove(encode_move(from, to, pawnType, Movetype::Capture), list);
+            else AddMove(encode_move(from, to, Movetype::Capture), list);
         }
 
         while (captBB2) {
             const int to = popLsb(captBB2);
             const int from = to - north - 1;
             if ((0xFF000000000000FFULL >> to) & 1) {
-                AddMove(encode_move(from, to, pawnType, (Movetype::queenPromo | Movetype::Capture)), list);
-                AddMove(encode_move(from, to, pawnType, (Movetype::rookPromo | Movetype::Capture)), list); 
-                AddMove(encode_move(from, to, pawnType, (Movetype::bishopPromo | Movetype::Capture)), list);
-                AddMove(encode_move(from, to, pawnType, (Movetype::knightPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::queenPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::rookPromo | Movetype::Capture)), list); 
+                AddMove(encode_move(from, to, (Movetype::bishopPromo | Movetype::Capture)), list);
+                AddMove(encode_move(from, to, (Movetype::knightPromo | Movetype::Capture)), list);
             }
-            else AddMove(encode_move(from, to, pawnType, Movetype::Capture), list);
+            else AddMove(encode_move(from, to, Movetype::Capture), list);
         }
 
         const int epSq = pos->getEpSquare();
@@ -130,14 +146,18 @@ static inline void PseudoLegalPawnMoves(Position* pos, int color, MoveList* list
         Bitboard epPieces = getPawnAttacks(epSq, color ^ 1) & ourPawns;
         while (epPieces) {
             int from = popLsb(epPieces);
-            AddMove(encode_move(from, epSq, pawnType, Movetype::enPassant), list);
+            const Move move = encode_move(from, epSq, Movetype::enPassant);
+            if (!legal || IsLegal(pos, move))
+                AddMove(move, list);
         }
     }
 }
 
-static inline void PseudoLegalKnightMoves(Position* pos, int color, MoveList* list, MovegenType type) {
+// Generates the knight moves that land on targetMask, pinned knights can never move so they are skipped in legal mode
+static inline void KnightMoves(Position* pos, int color, Bitboard targetMask, MoveList* list, MovegenType type, bool legal) {
     Bitboard knights = pos->getPieceColorBB(KNIGHT, color);
-    const int knightType = GetPiece(KNIGHT, color);
+    if (legal)
+        knights &= ~pos->getPinnedMask(color);
     const bool genNoisy = type & MOVEGEN_NOISY;
     const bool genQuiet = type & MOVEGEN_QUIET;
     Bitboard moveMask = 0ULL; // We restrict the number of squares the knight can travel to
@@ -150,21 +170,26 @@ static inline void PseudoLegalKnightMoves(Position* pos, int color, MoveList* li
     if (genQuiet)
         moveMask |= ~pos->Occupancy(BOTH);
 
+    moveMask &= targetMask;
+
     while (knights) {
         const int from = popLsb(knights);
         Bitboard possible_moves = getKnightAttacks(from) & moveMask;
         while (possible_moves) {
             const int to = popLsb(possible_moves);
             const Movetype movetype = pos->PieceOn(to) != EMPTY ? Movetype::Capture : Movetype::Quiet;
-            AddMove(encode_move(from, to, knightType, movetype), list);
+            AddMove(encode_move(from, to, movetype), list);
         }
     }
 }
 
-static inline void PseudoLegalSlidersMoves(Position *pos, int color, MoveList *list, MovegenType type) {
+// Generates the slider moves that land on targetMask, in legal mode pinned sliders can only move along the pin
+static inline void SlidersMoves(Position *pos, int color, Bitboard targetMask, MoveList *list, MovegenType type, bool legal) {
     const bool genNoisy = type & MOVEGEN_NOISY;
     const bool genQuiet = type & MOVEGEN_QUIET;
     Bitboard boardOccupancy = pos->Occupancy(BOTH);
+    const Bitboard pinned = legal ? pos->getPinnedMask(color) : 0ULL;
+    const Square ksq = KingSQ(pos, color);
     Bitboard moveMask = 0ULL; // We restrict the number of squares the bishop can travel to
 
     // The type requested includes noisy moves
@@ -175,24 +200,27 @@ static inline void PseudoLegalSlidersMoves(Position *pos, int color, MoveList *l
     if (genQuiet)
         moveMask |= ~pos->Occupancy(BOTH);
 
+    moveMask &= targetMask;
+
     for (int piecetype = BISHOP; piecetype <= QUEEN; piecetype++) {
         Bitboard pieces = pos->getPieceColorBB(piecetype, color);
-        const int coloredPieceValue = GetPiece(piecetype, color);
         while (pieces) {
             const int from = popLsb(pieces);
             Bitboard possible_moves =
                     pieceAttacks(piecetype, from, boardOccupancy) & moveMask;
+            if ((1ULL << from) & pinned)
+                possible_moves &= LINE_BB[ksq][from];
             while (possible_moves) {
                 const int to = popLsb(possible_moves);
                 const Movetype movetype = pos->PieceOn(to) != EMPTY ? Movetype::Capture : Movetype::Quiet;
-                AddMove(encode_move(from, to, coloredPieceValue, movetype), list);
+                AddMove(encode_move(from, to, movetype), list);
             }
         }
     }
 }
 
-static inline void PseudoLegalKingMoves(Position* pos, int color, MoveList* list, MovegenType type) {
-    const int kingType = GetPiece(KING, color);
+// Generates the king moves, in legal mode only the ones that don't walk into an attack
+static inline void KingMoves(Position* pos, int color, MoveList* list, MovegenType type, bool legal) {
     const int from = KingSQ(pos, color);
     const bool genNoisy = type & MOVEGEN_NOISY;
     const bool genQuiet = type & MOVEGEN_QUIET;
@@ -206,11 +234,15 @@ static inline void PseudoLegalKingMoves(Position* pos, int color, MoveList* list
     if (genQuiet)
         moveMask |= ~pos->Occupancy(BOTH);
 
+    // The king doesn't block the attacks of a slider along the line it's moving on, so it's taken off the board
+    const Bitboard occWithoutKing = pos->Occupancy(BOTH) ^ (1ULL << from);
     Bitboard possible_moves = getKingAttacks(from) & moveMask;
     while (possible_moves) {
         const int to = popLsb(possible_moves);
+        if (legal && IsKingSquareAttacked(pos, to, color ^ 1, occWithoutKing))
+            continue;
         Movetype movetype = pos->PieceOn(to) != EMPTY ? Movetype::Capture : Movetype::Quiet;
-        AddMove(encode_move(from, to, kingType, movetype), list);
+        AddMove(encode_move(from, to, movetype), list);
     }
 
     // Only generate castling moves if we are generating quiets
@@ -220,21 +252,33 @@ static inline void PseudoLegalKingMoves(Position* pos, int color, MoveList* list
         const int castlePerms = pos->getCastlingPerm();
         if (color == WHITE) {
             // king side castling is available
-            if ((castlePerms & WKCA) && !(occ & 0x6000000000000000ULL))
-                AddMove(encode_move(e1, g1, WK, Movetype::KSCastle), list);
+            if ((castlePerms & WKCA) && !(occ & 0x6000000000000000ULL)) {
+                const Move move = encode_move(e1, g1, Movetype::KSCastle);
+                if (!legal || IsLegal(pos, move))
+                    AddMove(move, list);
+            }
 
             // queen side castling is available
-            if ((castlePerms & WQCA) && !(occ & 0x0E00000000000000ULL))
-                AddMove(encode_move(e1, c1, WK, Movetype::QSCastle), list);
+            if ((castlePerms & WQCA) && !(occ & 0x0E00000000000000ULL)) {
+                const Move move = encode_move(e1, c1, Movetype::QSCastle);
+                if (!legal || IsLegal(pos, move))
+                    AddMove(move, list);
+            }
         }
         else {
             // king side castling is available
-            if ((castlePerms & BKCA) && !(occ & 0x0000000000000060ULL))
-                AddMove(encode_move(e8, g8, BK, Movetype::KSCastle), list);
+            if ((castlePerms & BKCA) && !(occ & 0x0000000000000060ULL)) {
+                const Move move = encode_move(e8, g8, Movetype::KSCastle);
+                if (!legal || IsLegal(pos, move))
+                    AddMove(move, list);
+            }
 
             // queen side castling is available
-            if ((castlePerms & BQCA) && !(occ & 0x000000000000000EULL))
-                AddMove(encode_move(e8, c8, BK, Movetype::QSCastle), list);
+            if ((castlePerms & BQCA) && !(occ & 0x000000000000000EULL)) {
+                const Move move = encode_move(e8, c8, Movetype::QSCastle);
+                if (!legal || IsLegal(pos, move))
+                    AddMove(move, list);
+            }
         }
     }
 }
@@ -246,11 +290,53 @@ void GenerateMoves(MoveList* move_list, Position* pos, MovegenType type) {
 
     const int checks = CountBits(pos->getCheckers());
     if (checks < 2) {
-        PseudoLegalPawnMoves(pos, pos->side, move_list, type);
-        PseudoLegalKnightMoves(pos, pos->side, move_list, type);
-        PseudoLegalSlidersMoves(pos, pos->side, move_list, type);
+        PawnMoves(pos, pos->side, pos->getPieceColorBB(PAWN, pos->side), ~0ULL, move_list, type, false);
+        KnightMoves(pos, pos->side, ~0ULL, move_list, type, false);
+        SlidersMoves(pos, pos->side, ~0ULL, move_list, type, false);
     }
-    PseudoLegalKingMoves(pos, pos->side, move_list, type);
+    KingMoves(pos, pos->side, move_list, type, false);
+}
+
+void GenerateEvasions(MoveList* move_list, Position* pos) {
+
+    assert(pos->getCheckers());
+
+    const Bitboard checkers = pos->getCheckers();
+    // In double check only the king can move
+    if (CountBits(checkers) < 2) {
+        const Bitboard checkMask = checkers | RayBetween(KingSQ(pos, pos->side), GetLsbIndex(checkers));
+        PawnMoves(pos, pos->side, pos->getPieceColorBB(PAWN, pos->side), checkMask, move_list, MOVEGEN_ALL, false);
+        KnightMoves(pos, pos->side, checkMask, move_list, MOVEGEN_ALL, false);
+        SlidersMoves(pos, pos->side, checkMask, move_list, MOVEGEN_ALL, false);
+    }
+    KingMoves(pos, pos->side, move_list, MOVEGEN_ALL, false);
+}
+
+void GenerateLegalMoves(MoveList* move_list, Position* pos, MovegenType type) {
+
+    assert(type == MOVEGEN_ALL || type == MOVEGEN_NOISY || type == MOVEGEN_QUIET);
+
+    const int color = pos->side;
+    const Bitboard checkers = pos->getCheckers();
+    // In double check only the king can move
+    if (CountBits(checkers) < 2) {
+        const Square ksq = KingSQ(pos, color);
+        // In check the other pieces have to capture the checker or block its attack
+        const Bitboard checkMask = checkers ? checkers | RayBetween(ksq, GetLsbIndex(checkers)) : ~0ULL;
+        const Bitboard pawns = pos->getPieceColorBB(PAWN, color);
+        Bitboard pinnedPawns = pawns & pos->getPinnedMask(color);
+        PawnMoves(pos, color, pawns ^ pinnedPawns, checkMask, move_list, type, true);
+        // A pinned piece can't help against a check, otherwise it can only move along the pin
+        if (!checkers) {
+            while (pinnedPawns) {
+                const int from = popLsb(pinnedPawns);
+                PawnMoves(pos, color, 1ULL << from, LINE_BB[ksq][from], move_list, type, true);
+            }
+        }
+        KnightMoves(pos, color, checkMask, move_list, type, true);
+        SlidersMoves(pos, color, checkMask, move_list, type, true);
+    }
+    KingMoves(pos, color, move_list, type, true);
 }
 
 // generate moves
@@ -270,62 +356,58 @@ void generateQuietChecks(MoveList* movelist, Position* pos) {
         // generate the moves for all the pawns we've got
         while (whitePawns) {
             const int from = popLsb(whitePawns);
-            AddMove(encode_move(from, from - 8, WP, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, from - 8, Movetype::Quiet), movelist);
         }
     }
     else {
         Bitboard blackPawns = (pawnCheckSquares >> 8) & pos->getPieceColorBB(PAWN, BLACK);
         while (blackPawns) {
             const int from = popLsb(blackPawns);
-            AddMove(encode_move(from, from + 8, BP, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, from + 8, Movetype::Quiet), movelist);
         }
     }
 
     Bitboard knights = pos->getPieceColorBB(KNIGHT, stm) & ~pinned;
     Bitboard knightCheckSquares = getKnightAttacks(oppKingSq) & ~occupied;
-    const int knightType = GetPiece(KNIGHT, stm);
     while (knights) {
         const int from = popLsb(knights);
         Bitboard possible_moves = getKnightAttacks(from) & knightCheckSquares;
         while (possible_moves) {
             const int to = popLsb(possible_moves);
-            AddMove(encode_move(from, to, knightType, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, to, Movetype::Quiet), movelist);
         }
     }
 
     Bitboard bishops = pos->getPieceColorBB(BISHOP, stm);
     Bitboard bishopCheckSquares = getBishopAttacks(oppKingSq, occupied) & ~occupied;
-    const int bishopType = GetPiece(BISHOP, stm);
     while (bishops) {
         const int from = popLsb(bishops);
         Bitboard possible_moves = getBishopAttacks(from, occupied) & bishopCheckSquares;
         while (possible_moves) {
             const int to = popLsb(possible_moves);
-            AddMove(encode_move(from, to, bishopType, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, to, Movetype::Quiet), movelist);
         }
     }
 
     Bitboard rooks = pos->getPieceColorBB(ROOK, stm);
     Bitboard rookCheckSquares = getRookAttacks(oppKingSq, occupied) & ~occupied;
-    const int rookType = GetPiece(ROOK, stm);
     while (rooks) {
         const int from = popLsb(rooks);
         Bitboard possible_moves = getRookAttacks(from, occupied) & rookCheckSquares;
         while (possible_moves) {
             const int to = popLsb(possible_moves);
-            AddMove(encode_move(from, to, rookType, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, to, Movetype::Quiet), movelist);
         }
     }
 
     Bitboard queens = pos->getPieceColorBB(QUEEN, stm);
     Bitboard queenCheckSquares = bishopCheckSquares | rookCheckSquares;
-    const int queenType = GetPiece(QUEEN, stm);
     while (queens) {
         const int from = popLsb(queens);
         Bitboard possible_moves = getQueenAttacks(from, occupied) & queenCheckSquares;
         while (possible_moves) {
             const int to = popLsb(possible_moves);
-            AddMove(encode_move(from, to, queenType, Movetype::Quiet), movelist);
+            AddMove(encode_move(from, to, Movetype::Quiet), movelist);
         }
     }
 }
@@ -338,7 +420,7 @@ bool IsPseudoLegal(Position* pos, Move move) {
 
     const Square from = From(move);
     const Square to = To(move);
-    const int movedPiece = Piece(move);
+    const int movedPiece = MovedPiece(pos, move);
     const int pieceType = GetPieceType(movedPiece);
 
     if (from == to)
@@ -347,9 +429,6 @@ bool IsPseudoLegal(Position* pos, Move move) {
     if (movedPiece == EMPTY)
         return false;
 
-    if (pos->PieceOn(from) != movedPiece)
-        return false;
-
     if (Color[movedPiece] != pos->side)
         return false;
 
@@ -488,27 +567,20 @@ bool IsPseudoLegal(Position* pos, Move move) {
     return true;
 }
 
-bool IsLegal(Position* pos, Move move) {
+bool IsLegal(const Position* pos, Move move) {
 
     const int color = pos->side;
     const Square ksq = KingSQ(pos, color);
     const Square from = From(move);
     const Square to = To(move);
-    const int movedPiece = Piece(move);
+    const int movedPiece = MovedPiece(pos, move);
     const int pieceType = GetPieceType(movedPiece);
 
     if (isEnpassant(move)) {
-        int offset = color == WHITE ? 8 : -8;
-        int ourPawn = GetPiece(PAWN, color);
-        int theirPawn = GetPiece(PAWN, color ^ 1);
-        ClearPiece(ourPawn, from, pos);
-        ClearPiece(theirPawn, to + offset, pos);
-        AddPiece(ourPawn, to, pos);
-        bool isLegal = !IsSquareAttacked(pos, ksq, color ^ 1);
-        AddPiece(ourPawn, from, pos);
-        AddPiece(theirPawn, to + offset, pos);
-        ClearPiece(ourPawn, to, pos);
-        return isLegal;
+        // Look at the board as it would be after the capture, both pawns leave their square so the king might end up exposed along a rank
+        const int offset = color == WHITE ? 8 : -8;
+        const Bitboard occ = (pos->Occupancy(BOTH) ^ (1ULL << from) ^ (1ULL << (to + offset))) | (1ULL << to);
+        return !IsSquareAttacked(pos, ksq, color ^ 1, occ);
     }
     else if (isCastle(move)) {
         bool isKSCastle = GetMovetype(move) == static_cast<int>(Movetype::KSCastle);
@@ -523,11 +595,8 @@ bool IsLegal(Position* pos, Move move) {
     }
 
     if (pieceType == KING) {
-        int king = GetPiece(KING, color);
-        ClearPiece(king, ksq, pos);
-        bool isLegal = !IsSquareAttacked(pos, to, color ^ 1);
-        AddPiece(king, ksq, pos);
-        return isLegal;
+        // The king doesn't block the attacks of a slider along the line it's moving on, so it's taken off the board
+        return !IsKingSquareAttacked(pos, to, color ^ 1, pos->Occupancy(BOTH) ^ (1ULL << ksq));
     }
     else if (pos->getPinnedMask(pos->side) & (1ULL << from)) {
         return !pos->getCheckers() && (((1ULL << to) & RayBetween(ksq, from)) || ((1ULL << from) & RayBetween(ksq, to)));
@@ -15,6 +15,9 @@ enum MovegenType : uint8_t {
 // is the square given in input attacked by the current given side
 [[nodiscard]] bool IsSquareAttacked(const Position* pos, const int square, const int side);
 
+// is the square given in input attacked by the current given side if the board was occupied by occ, pieces missing from occ don't attack
+[[nodiscard]] bool IsSquareAttacked(const Position* pos, const int square, const int side, const Bitboard occ);
+
 // function that adds a (not yet scored) move to a move list
 void AddMove(const Move move, MoveList* list);
 
@@ -30,9 +33,15 @@ void quietChecks(Position* pos, MoveList* movelist);
 [[nodiscard]] bool IsPseudoLegal(Position* pos, Move move);
 
 // Check for move legality
-[[nodiscard]] bool IsLegal(Position* pos, Move move);
+[[nodiscard]] bool IsLegal(const Position* pos, Move move);
 
 // generate moves
 void GenerateMoves(MoveList* move_list, Position* pos, MovegenType type);
 
+// generate the moves that could get the side to move out of check: king moves, captures of the checker and blocks
+void GenerateEvasions(MoveList* move_list, Position* pos);
+
+// generate only the legal moves, using the pins and checkers of the position instead of checking every move
+void GenerateLegalMoves(MoveList* move_list, Position* pos, MovegenType type = MOVEGEN_ALL);
+
 void generateQuietChecks( MoveList* movelist, Position* pos);
@@ -12,37 +12,41 @@ void ScoreMoves(Movepicker* mp) {
     bool rootNode = mp->rootNode;
     // Loop through all the move in the movelist
     for (int i = mp->idx; i < moveList->count; i++) {
-        const Move move = moveList->moves[i].move;
+        const Move move = moveList->moves[i];
         if (isTactical(move)) {
             // Score by most valuable victim and capthist
             int capturedPiece = isEnpassant(move) ? PAWN : GetPieceType(pos->PieceOn(To(move)));
-            moveList->moves[i].score = SEEValue[capturedPiece] * 16 + GetCapthistScore(pos, sd, move);
+            moveList->scores[i] = SEEValue[capturedPiece] * 16 + GetCapthistScore(pos, sd, move);
         }
         else {
-            moveList->moves[i].score = GetHistoryScore(pos, sd, move, ss, rootNode);
+            moveList->scores[i] = GetHistoryScore(pos, sd, move, ss, rootNode);
         }
     }
 }
 
 void partialInsertionSort(MoveList* moveList, const int moveNum) {
-    int bestScore = moveList->moves[moveNum].score;
+    int bestScore = moveList->scores[moveNum];
     int bestNum = moveNum;
     // starting at the number of the current move and stopping at the end of the list
     for (int index = moveNum + 1; index < moveList->count; ++index) {
         // if we find a move with a better score than our bestmove we use that as the new best move
-        if (moveList->moves[index].score > bestScore) {
-            bestScore = moveList->moves[index].score;
+        if (moveList->scores[index] > bestScore) {
+            bestScore = moveList->scores[index];
             bestNum = index;
         }
     }
     // swap the move with the best score with the move in place moveNum
     std::swap(moveList->moves[moveNum], moveList->moves[bestNum]);
+    std::swap(moveList->scores[moveNum], moveList->scores[bestNum]);
 }
 
 void InitMP(Movepicker* mp, Position* pos, SearchData* sd, SearchStack* ss, const Move ttMove, const int SEEThreshold, const MovepickerType movepickerType, const bool rootNode) {
 
-    const Move killer = ss->searchKiller;
-    const Move counter = sd->counterMoves[FromTo((ss - 1)->move)];
+    // Killers and counters that aren't played by the same piece anymore are discarded
+    const Move killer = MovedPiece(pos, ss->searchKiller) == ss->killerPiece ? ss->searchKiller : NOMOVE;
+    const Move counter = MovedPiece(pos, sd->counterMoves[FromTo((ss - 1)->move)]) == sd->counterPieces[FromTo((ss - 1)->move)]
+                       ? sd->counterMoves[FromTo((ss - 1)->move)]
+                       : NOMOVE;
 
     mp->movepickerType = movepickerType;
     mp->pos = pos;
@@ -52,15 +56,20 @@ void InitMP(Movepicker* mp, Position* pos, SearchData* sd, SearchStack* ss, cons
     mp->idx = 0;
     mp->badcapturesCount = 0;
     mp->rootNode = rootNode;
-    mp->stage = mp->ttMove ? PICK_TT : GEN_NOISY;
+    mp->evasion = pos->getCheckers() && movepickerType != PROBCUT;
+    mp->stage = mp->ttMove ? PICK_TT : mp->evasion ? GEN_EVASIONS : GEN_NOISY;
     mp->killer = killer != ttMove ? killer : NOMOVE;
     mp->counter = counter != ttMove && counter != killer ? counter : NOMOVE;
     mp->SEEThreshold = SEEThreshold;
+    mp->moveSEE = SCORE_NONE;
+    mp->seeCache.known = 0;
 }
 
 Move NextMove(Movepicker* mp, const bool skip) {
+    mp->moveSEE = SCORE_NONE;
     top:
-    if (skip) {
+    // The evasion stage handles skipping by itself
+    if (skip && !mp->evasion) {
         // In search, the skip variable is used to dictate whether we skip quiet moves
         if (   mp->movepickerType == SEARCH
             && mp->stage > PICK_GOOD_NOISY
@@ -82,7 +91,7 @@ Move NextMove(Movepicker* mp, const bool skip) {
     }
     switch (mp->stage) {
     case PICK_TT:
-        ++mp->stage;
+        mp->stage = mp->evasion ? GEN_EVASIONS : GEN_NOISY;
             // If we are in qsearch and not in check, or we are in probcut, skip quiet TT moves
             if ((mp->movepickerType == PROBCUT || (mp->movepickerType == QSEARCH && skip))
                 && !isTactical(mp->ttMove))
@@ -93,8 +102,13 @@ Move NextMove(Movepicker* mp, const bool skip) {
             goto top;
 
         // If we are in probcut and the TT move does not pass SEE, we skip it
-        if (mp->movepickerType == PROBCUT && !SEE(mp->pos, mp->ttMove, mp->SEEThreshold))
-            goto top;
+        if (mp->movepickerType == PROBCUT) {
+            mp->moveSEE = SEEScore(mp->pos, mp->ttMove, &mp->seeCache);
+            if (mp->moveSEE < mp->SEEThreshold) {
+                mp->moveSEE = SCORE_NONE;
+                goto top;
+            }
+        }
 
         return mp->ttMove;
 
@@ -107,20 +121,24 @@ Move NextMove(Movepicker* mp, const bool skip) {
     case PICK_GOOD_NOISY:
         while (mp->idx < mp->moveList.count) {
             partialInsertionSort(&mp->moveList, mp->idx);
-            const Move move = mp->moveList.moves[mp->idx].move;
-            const int score = mp->moveList.moves[mp->idx].score;
+            const Move move = mp->moveList.moves[mp->idx];
+            const int score = mp->moveList.scores[mp->idx];
             const int SEEThreshold =  mp->movepickerType == PROBCUT ? mp->SEEThreshold : -score / 32 + 236;
             ++mp->idx;
             if (move == mp->ttMove)
                 continue;
 
-            if (!SEE(mp->pos, move, SEEThreshold)) {
-                // since these moves are already sorted we can ditch the score, it won't be checked again
-                mp->moveList.moves[mp->badcapturesCount++].move = move;
+            // Every capture gets its exact SEE value once, so the search can check it against any threshold for free
+            const int see = SEEScore(mp->pos, move, &mp->seeCache);
+            if (see < SEEThreshold) {
+                // since these moves are already sorted we can replace the score with the SEE value, it won't be sorted again
+                mp->moveList.moves[mp->badcapturesCount] = move;
+                mp->moveList.scores[mp->badcapturesCount++] = see;
                 continue;
             }
 
             assert(isTactical(move));
+            mp->moveSEE = see;
 
             return move;
         }
@@ -148,7 +166,7 @@ Move NextMove(Movepicker* mp, const bool skip) {
     case PICK_QUIETS:
         while (mp->idx < mp->moveList.count) {
             partialInsertionSort(&mp->moveList, mp->idx);
-            const Move move = mp->moveList.moves[mp->idx].move;
+            const Move move = mp->moveList.moves[mp->idx];
             ++mp->idx;
             if (   move == mp->ttMove
                 || move == mp->killer
@@ -169,12 +187,40 @@ Move NextMove(Movepicker* mp, const bool skip) {
 
     case PICK_BAD_NOISY:
         while (mp->idx < mp->badcapturesCount) {
-            const Move move = mp->moveList.moves[mp->idx].move;
+            const Move move = mp->moveList.moves[mp->idx];
+            const int see = mp->moveList.scores[mp->idx];
             ++mp->idx;
             if (move == mp->ttMove)
                 continue;
 
             assert(isTactical(move));
+            mp->moveSEE = see;
+            return move;
+        }
+        return NOMOVE;
+
+    case GEN_EVASIONS:
+        GenerateEvasions(&mp->moveList, mp->pos);
+        ScoreMoves(mp);
+        // Captures of the checker (and promotions that block it) go first, SEE can't tell us much about them when we are in check
+        for (int i = 0; i < mp->moveList.count; i++)
+            if (isTactical(mp->moveList.moves[i]))
+                mp->moveList.scores[i] += 1 << 28;
+        ++mp->stage;
+        goto top;
+
+    case PICK_EVASIONS:
+        while (mp->idx < mp->moveList.count) {
+            partialInsertionSort(&mp->moveList, mp->idx);
+            const Move move = mp->moveList.moves[mp->idx];
+            ++mp->idx;
+            if (move == mp->ttMove)
+                continue;
+
+            // The tactical evasions come first, so once we are skipping quiets there's nothing left to return
+            if (skip && !isTactical(move))
+                return NOMOVE;
+
             return move;
         }
         return NOMOVE;
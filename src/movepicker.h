@@ -13,7 +13,9 @@ enum {
     GEN_QUIETS,
     PICK_QUIETS,
     GEN_BAD_NOISY,
-    PICK_BAD_NOISY
+    PICK_BAD_NOISY,
+    GEN_EVASIONS,
+    PICK_EVASIONS
 };
 
 enum MovepickerType : uint8_t {
@@ -35,7 +37,12 @@ struct Movepicker {
     uint8_t stage;
     uint16_t badcapturesCount;
     int SEEThreshold;
+    // Exact SEE of the move we returned last, SCORE_NONE if we didn't need it to pick the move
+    int moveSEE;
+    SEECache seeCache;
     bool rootNode;
+    // In check (outside of probcut) we only generate the moves that can get us out of it
+    bool evasion;
 };
 
 void InitMP(Movepicker* mp, Position* pos, SearchData* sd, SearchStack* ss, const Move ttMove, const int SEEThreshold, const MovepickerType movepickerType, const bool rootNode);
@@ -102,8 +102,9 @@ void NNUE::povActivateAffine(Position *pos, NNUE::FinnyTable *FinnyPointer, cons
     size_t addCnt = 0, removeCnt = 0;
 
     for (int piece = WP; piece <= BK; piece++) {
-        Bitboard added = pos->state().bitboards[piece] & ~cachedEntry.occupancies[piece];
-        Bitboard removed = cachedEntry.occupancies[piece] & ~pos->state().bitboards[piece];
+        const Bitboard pieceBB = pos->getPieceColorBB(PieceType[piece], Color[piece]);
+        Bitboard added = pieceBB & ~cachedEntry.occupancies[piece];
+        Bitboard removed = cachedEntry.occupancies[piece] & ~pieceBB;
         while (added) {
             int square = popLsb(added);
             add[addCnt++] = getIndex(piece, square, side, kingBucket, flip);
@@ -114,7 +115,7 @@ void NNUE::povActivateAffine(Position *pos, NNUE::FinnyTable *FinnyPointer, cons
             remove[removeCnt++] = getIndex(piece, square, side, kingBucket, flip);
         }
 
-        cachedEntry.occupancies[piece] = pos->state().bitboards[piece];
+        cachedEntry.occupancies[piece] = pieceBB;
     }
 
 
@@ -5,106 +5,142 @@
 #include "misc.h"
 #include "movegen.h"
 #include "move.h"
+#include "ttable.h"
+#include <atomic>
 #include <iostream>
+#include <memory>
+#include <thread>
+
+// An entry of the perft hash table, data packs the node count with the depth it was computed at
+// and check is the position key xored with data, so that an entry torn by a concurrent write never validates
+struct PerftEntry {
+    std::atomic<uint64_t> check = 0;
+    std::atomic<uint64_t> data = 0;
+};
+
+struct PerftTable {
+    std::unique_ptr<PerftEntry[]> entries;
+    uint64_t size = 0;
+};
+
+// The table of the running perft test, empty if hashing is disabled
+static PerftTable perftTable;
+
+[[nodiscard]] static inline PerftEntry* PerftIndex(const ZobristKey key) {
+    return &perftTable.entries[MulHi64(key, perftTable.size)];
+}
 
-// leaf nodes (number of positions reached during the test of the move generator
-// at a given depth)
-uint64_t nodes;
-// perft driver
-void PerftDriver(int depth, Position* pos, std::vector<ZobristKey>& keyHistory) {
-    // create move list instance
-    MoveList moveList;
+[[nodiscard]] static inline bool ProbePerft(const ZobristKey key, const int depth, uint64_t& nodes) {
+    const PerftEntry* entry = PerftIndex(key);
+    const uint64_t data = entry->data.load(std::memory_order_relaxed);
+    const uint64_t check = entry->check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || static_cast<int>(data & 0xFF) != depth)
+        return false;
+    nodes = data >> 8;
+    return true;
+}
 
-    // Non bulk Counting
-    if (depth == 0) {
-        nodes += 1;
-        return;
-    }
+static inline void StorePerft(const ZobristKey key, const int depth, const uint64_t nodes) {
+    PerftEntry* entry = PerftIndex(key);
+    const uint64_t data = nodes << 8 | static_cast<uint64_t>(depth);
+    entry->check.store(key ^ data, std::memory_order_relaxed);
+    entry->data.store(data, std::memory_order_relaxed);
+}
 
-    // generate moves
-    GenerateMoves(&moveList, pos, MOVEGEN_ALL);
+uint64_t PerftDriver(int depth, Position* pos) {
+    if (depth == 0)
+        return 1;
 
-    if (depth == 1) {
-        // loop over generated moves
-        for (int moveCount = 0; moveCount < moveList.count; moveCount++) {
-            Move move = moveList.moves[moveCount].move;
-            if (!IsLegal(pos, move))
-                continue;
+    // Hashing the last 2 plies costs more than it saves
+    const bool useHash = perftTable.size && depth >= 3;
+    uint64_t nodes = 0;
+    if (useHash && ProbePerft(pos->getPoskey(), depth, nodes))
+        return nodes;
 
-            nodes += 1;
-        }
-        return;
-    }
+    // create move list instance
+    MoveList moveList;
+
+    // generate legal moves
+    GenerateLegalMoves(&moveList, pos);
+
+    // Bulk counting, the leaf nodes are the legal moves
+    if (depth == 1)
+        return moveList.count;
 
     // loop over generated moves
     for (int moveCount = 0; moveCount < moveList.count; moveCount++) {
-        Move move = moveList.moves[moveCount].move;
-        if (!IsLegal(pos, move))
-            continue;
+        const Move move = moveList.moves[moveCount];
 
         // make move
-        MakeMove<true>(move, pos, keyHistory);
+        MakeMove<true>(move, pos);
 
         // call perft driver recursively
-        PerftDriver(depth - 1, pos, keyHistory);
+        nodes += PerftDriver(depth - 1, pos);
 
         // take back
-        UnmakeMove(pos, keyHistory);
+        UnmakeMove(pos);
     }
+
+    if (useHash)
+        StorePerft(pos->getPoskey(), depth, nodes);
+    return nodes;
 }
 
-// perft test
-unsigned long long PerftTest(int depth, Position* pos, std::vector<ZobristKey>& keyHistory) {
-    nodes = 0;
+uint64_t PerftTest(int depth, Position* pos, int threadCount, int hash) {
     std::cout << ("\n     Performance test\n\n");
 
-    // create move list instance
-    MoveList moveList;
+    if (hash) {
+        perftTable.size = static_cast<uint64_t>(hash) * 1024 * 1024 / sizeof(PerftEntry);
+        perftTable.entries = std::make_unique<PerftEntry[]>(perftTable.size);
+    }
 
-    // generate moves
-    GenerateMoves(&moveList, pos, MOVEGEN_ALL);
+    // generate the legal root moves
+    MoveList rootMoves;
+    GenerateLegalMoves(&rootMoves, pos);
+    uint64_t rootNodes[256] = {};
 
     // init start time
-    long start = GetTimeMs();
-
-    // loop over generated moves
-    for (int moveCount = 0; moveCount < moveList.count; moveCount++) {
-        const Move move = moveList.moves[moveCount].move;
-
-        if (!IsLegal(pos, move))
-            continue;
-
-        // make move
-        MakeMove<true>(move, pos, keyHistory);
-
-        // cummulative nodes
-        long cummulative_nodes = nodes;
-
-        // call perft driver recursively
-        PerftDriver(depth - 1, pos, keyHistory);
-
-        // take back
-        UnmakeMove(pos, keyHistory);
-
-        // old nodes
-        long old_nodes = nodes - cummulative_nodes;
-
-        // print move
-        printf(" %s%s%c: %ld\n",
+    const uint64_t start = GetTimeMs();
+
+    // Every thread searches the next root move nobody has taken yet on its own copy of the position
+    std::atomic<int> nextMove = 0;
+    const auto worker = [&]() {
+        auto threadPos = std::make_unique<Position>(*pos);
+        for (int moveCount = nextMove++; moveCount < rootMoves.count; moveCount = nextMove++) {
+            MakeMove<true>(rootMoves.moves[moveCount], threadPos.get());
+            rootNodes[moveCount] = PerftDriver(depth - 1, threadPos.get());
+            UnmakeMove(threadPos.get());
+        }
+    };
+    std::vector<std::thread> workers;
+    for (int i = 0; i < std::min(threadCount, rootMoves.count); i++)
+        workers.emplace_back(worker);
+    for (auto& thread : workers)
+        thread.join();
+
+    const uint64_t time = GetTimeMs() - start;
+
+    // print the divide in move generation order
+    uint64_t nodes = 0;
+    for (int moveCount = 0; moveCount < rootMoves.count; moveCount++) {
+        const Move move = rootMoves.moves[moveCount];
+        printf(" %s%s%c: %llu\n",
             square_to_coordinates[From(move)],
             square_to_coordinates[To(move)],
             isPromo(move)
             ? promoted_pieces[getPromotedPiecetype(move)]
             : ' ',
-            old_nodes);
+            static_cast<unsigned long long>(rootNodes[moveCount]));
+        nodes += rootNodes[moveCount];
     }
 
-    auto time = GetTimeMs() - start;
+    perftTable = PerftTable();
+
     // print results
     std::cout << "\n    Depth: " << depth << "\n";
     std::cout << "    Nodes: " << nodes << "\n";
     std::cout << "     Time: " << time << "\n";
-    unsigned long nodes_second = (nodes / (time + !time)) * 1000;
+    const uint64_t nodes_second = nodes * 1000 / (time + !time);
     std::cout << " Nodes per second: " << nodes_second << "\n\n";
 
     return nodes;
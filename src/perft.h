@@ -3,8 +3,9 @@
 
 struct Position;
 
-// perft driver
-void PerftDriver(int depth, Position* pos, std::vector<ZobristKey>& keyHistory);
+// perft driver, counts the leaf nodes of the tree of legal moves of the given depth
+[[nodiscard]] uint64_t PerftDriver(int depth, Position* pos);
 
-// perft test
-unsigned long long PerftTest(int depth, Position* pos, std::vector<ZobristKey>& keyHistory);
+// perft test, splits the root moves across threadCount threads and prints the node count of each of them
+// hash is the size in MB of the table used to share the subtree counts, 0 disables it
+uint64_t PerftTest(int depth, Position* pos, int threadCount = 1, int hash = 0);
@@ -13,7 +13,7 @@
 void ResetBoard(Position* pos) {
     pos->history.head = 0;
     // reset board position (pos->pos->bitboards)
-    std::memset(pos->state().bitboards, 0ULL, sizeof(pos->state().bitboards));
+    std::memset(pos->state().pieceTypeBB, 0ULL, sizeof(pos->state().pieceTypeBB));
 
     // reset pos->occupancies (pos->pos->bitboards)
     std::memset(pos->state().occupancies, 0ULL, sizeof(pos->state().occupancies));
@@ -23,6 +23,8 @@ void ResetBoard(Position* pos) {
     }
     pos->state().castlePerm = 0;
     pos->state().plyFromNull = 0;
+    pos->attackMaps().valid = 0;
+    pos->keyHistory.clear();
 }
 
 // Generates zobrist key from scratch
@@ -114,7 +116,8 @@ void ParseFen(const std::string& command, Position* pos) {
                 const int piece = char_pieces[current_char];
                 if (piece != EMPTY) {
                     // set piece on corresponding bitboard
-                    set_bit(pos->state().bitboards[piece], square);
+                    set_bit(pos->state().pieceTypeBB[PieceType[piece]], square);
+                    set_bit(pos->state().occupancies[Color[piece]], square);
                     pos->state().pieces[square] = piece;
                 }
                 fen_counter++;
@@ -196,14 +199,6 @@ void ParseFen(const std::string& command, Position* pos) {
         pos->state().hisPly = 1;
     }
 
-    for (int piece = WP; piece <= WK; piece++)
-        // populate white occupancy bitboard
-        pos->state().occupancies[WHITE] |= pos->state().bitboards[piece];
-
-    for (int piece = BP; piece <= BK; piece++)
-        // populate white occupancy bitboard
-        pos->state().occupancies[BLACK] |= pos->state().bitboards[piece];
-
     pos->state().posKey = GeneratePosKey(pos);
     pos->state().pawnKey = GeneratePawnKey(pos);
     pos->state().whiteNonPawnKey = GenerateNonPawnKey(pos, WHITE);
@@ -281,104 +276,62 @@ std::string GetFen(const Position* pos) {
 }
 
 // parses the moves part of a fen string and plays all the moves included
-void parse_moves(const std::string& moves, Position* pos, std::vector<ZobristKey>& keyHistory) {
-    std::vector<std::string> move_tokens = split_command(moves);
-    // loop over moves within a move string
-    for (size_t i = 0; i < move_tokens.size(); i++) {
+void parse_moves(std::span<const std::string> moves, Position* pos) {
+    // loop over moves within the move list
+    for (const auto& moveString : moves) {
         // parse next move
-        const Move move = ParseMove(move_tokens[i], pos);
+        const Move move = ParseMove(moveString, pos);
         // make move on the chess board
-        MakeMove<false>(move, pos, keyHistory);
+        MakeMove<false>(move, pos);
+        // Positions from before the last irreversible move can't be repeated, so drop them if we are running out of room
+        if (pos->keyHistory.size() >= MAXGAMEPLY)
+            pos->keyHistory.keepLast(std::min(pos->get50MrCounter(), MAXGAMEPLY / 2));
     }
 }
 
 // Returns the bitboard of a piecetype
 Bitboard getPieceBB(const Position* pos, const int piecetype) {
-    return pos->getPieceColorBB(piecetype, WHITE) | pos->getPieceColorBB(piecetype, BLACK);
+    return pos->state().pieceTypeBB[piecetype];
 }
 
 bool oppCanWinMaterial(const Position* pos, const int side) {
-    Bitboard occ = pos->Occupancy(BOTH);
-    Bitboard  us = pos->Occupancy(side);
-    Bitboard oppPawns = pos->getPieceColorBB(PAWN, side ^ 1);
-    Bitboard ourPawns = pos->getPieceColorBB(PAWN, side);
-    while (oppPawns) {
-        const int source_square = popLsb(oppPawns);
-        if (getPawnAttacks(source_square, side ^ 1) & (us ^ ourPawns))
-            return true;
-    }
-
-    Bitboard oppKnights = pos->getPieceColorBB(KNIGHT, side ^ 1);
-    Bitboard ourKnights = pos->getPieceColorBB(KNIGHT, side);
-    Bitboard oppBishops = pos->getPieceColorBB(BISHOP, side ^ 1);
-    Bitboard ourBishops = pos->getPieceColorBB(BISHOP, side);
-    while (oppKnights) {
-        const int source_square = popLsb(oppKnights);
-        if (getKnightAttacks(source_square) & (us ^ ourPawns ^ ourKnights ^ ourBishops))
-            return true;
-    }
-
-    while (oppBishops) {
-        const int source_square = popLsb(oppBishops);
-        if (getBishopAttacks(source_square, occ) & (us ^ ourPawns ^ ourKnights ^ ourBishops))
-            return true;
-    }
-
-    Bitboard oppRooks = pos->getPieceColorBB(ROOK, side ^ 1);
-    Bitboard ourRooks = pos->getPieceColorBB(ROOK, side);
-    while (oppRooks) {
-        const int source_square = popLsb(oppRooks);
-        if (getRookAttacks(source_square, occ) & (us ^ ourPawns ^ ourKnights ^ ourBishops ^ ourRooks))
-            return true;
-    }
-
-    return false;
+    const Bitboard us = pos->Occupancy(side);
+    const Bitboard ourPawns = pos->getPieceColorBB(PAWN, side);
+    const Bitboard ourMinors = pos->getPieceColorBB(KNIGHT, side) | pos->getPieceColorBB(BISHOP, side);
+    const Bitboard ourRooks = pos->getPieceColorBB(ROOK, side);
+    const AttackMaps& maps = GetAttackMaps(pos, side ^ 1);
+
+    return (maps.byPiece[side ^ 1][PAWN] & (us ^ ourPawns))
+        || ((maps.byPiece[side ^ 1][KNIGHT] | maps.byPiece[side ^ 1][BISHOP]) & (us ^ ourPawns ^ ourMinors))
+        || (maps.byPiece[side ^ 1][ROOK] & (us ^ ourPawns ^ ourMinors ^ ourRooks));
 }
 
-Bitboard getThreats(const Position* pos, const int side) {
-    // Take the occupancies of both positions, encoding where all the pieces on the board reside
-    Bitboard occ = pos->Occupancy(BOTH);
-    uint64_t threats = 0;
-
-    // Get Pawn attacks
-    Bitboard pawns = pos->getPieceColorBB(PAWN, side);
-    while (pawns) {
-        int source_square = popLsb(pawns);
-        threats |= getPawnAttacks(source_square, side);
-    }
-
-    // Get Knight attacks
-    Bitboard knights = pos->getPieceColorBB(KNIGHT, side);
-    while (knights) {
-        int source_square = popLsb(knights);
-        threats |= getKnightAttacks(source_square);
+const AttackMaps& GetAttackMaps(const Position* pos, const int side) {
+    AttackMaps& maps = pos->attackMaps();
+    if (maps.valid & (1 << side))
+        return maps;
+
+    // Take the occupancies of both positions, without the enemy king so that sliders see through it
+    const Bitboard occ = pos->Occupancy(BOTH) ^ pos->getPieceColorBB(KING, side ^ 1);
+    Bitboard* byPiece = maps.byPiece[side];
+
+    // Pawn attacks can be computed for all the pawns at once
+    const Bitboard pawns = pos->getPieceColorBB(PAWN, side);
+    byPiece[PAWN] = side == WHITE ? ((pawns & not_a_file) >> 9) | ((pawns & not_h_file) >> 7)
+                                  : ((pawns & not_a_file) << 7) | ((pawns & not_h_file) << 9);
+
+    for (int piecetype = KNIGHT; piecetype <= KING; piecetype++) {
+        byPiece[piecetype] = 0;
+        Bitboard pieces = pos->getPieceColorBB(piecetype, side);
+        while (pieces) {
+            const int source_square = popLsb(pieces);
+            byPiece[piecetype] |= pieceAttacks(piecetype, source_square, occ);
+        }
     }
 
-    // Get Bishop attacks
-    Bitboard bishops = pos->getPieceColorBB(BISHOP, side);
-    while (bishops) {
-        int source_square = popLsb(bishops);
-        threats |= getBishopAttacks(source_square, occ);
-    }
-    // Get Rook attacks
-    Bitboard rooks = pos->getPieceColorBB(ROOK, side);
-    while (rooks) {
-        int source_square = popLsb(rooks);
-        threats |= getRookAttacks(source_square, occ);
-    }
-    // Get Queen attacks
-    Bitboard queens = pos->getPieceColorBB(QUEEN, side);
-    while (queens) {
-        int source_square = popLsb(queens);
-        threats |= getQueenAttacks(source_square, occ);
-    }
-    // Get King attacks
-    Bitboard king = pos->getPieceColorBB(KING, side);
-    while (king) {
-        int source_square = popLsb(king);
-        threats |= getKingAttacks(source_square);
-    }
-    return threats;
+    maps.all[side] = byPiece[PAWN] | byPiece[KNIGHT] | byPiece[BISHOP] | byPiece[ROOK] | byPiece[QUEEN] | byPiece[KING];
+    maps.valid |= 1 << side;
+    return maps;
 }
 
 // Return a piece based on the piecetype and the color
@@ -458,7 +411,7 @@ ZobristKey keyAfter(const Position* pos, const Move move) {
 
     const Square sourceSquare = From(move);
     const Square targetSquare = To(move);
-    const int piece = Piece(move);
+    const int piece = MovedPiece(pos, move);
     const int  captured = pos->PieceOn(targetSquare);
 
     ZobristKey newKey = pos->getPoskey() ^ SideKey ^ PieceKeys[piece][sourceSquare] ^ PieceKeys[piece][targetSquare];
@@ -469,9 +422,10 @@ ZobristKey keyAfter(const Position* pos, const Move move) {
     return newKey;
 }
 
-bool hasGameCycle(Position* pos, const std::vector<ZobristKey>& keyHistory, int ply) {
+bool hasGameCycle(Position* pos, int ply) {
 
-    int end = std::min(pos->get50MrCounter(), pos->getPlyFromNull());
+    const KeyHistory& keyHistory = pos->keyHistory;
+    int end = std::min({ pos->get50MrCounter(), pos->getPlyFromNull(), keyHistory.size() });
 
     if (end < 3)
         return false;
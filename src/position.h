@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <cassert>
 #include <cctype>
 #include <cstring>
+#include <span>
 #include <string>
 #include <vector>
 #include "bitboard.h"
@@ -22,15 +24,11 @@
 #endif
 #define get_antidiagonal(sq) (get_rank[sq] + get_file[sq])
 
+// Everything that MakeMove copies on every node, so it's kept as compact as possible
 struct BoardState {
-    int pieces[64];
-    // Occupancies bitboards based on piece and side
-    Bitboard bitboards[12] = {};
+    // Piece type bitboards, the ones of a single color are obtained by intersecting them with the occupancies
+    Bitboard pieceTypeBB[6] = {};
     Bitboard occupancies[2] = {};
-    int castlePerm = 15;
-    int enPas = 0;
-    int fiftyMove = 0;
-    int plyFromNull = 0;
     Bitboard checkers = 0ULL;
     Bitboard pinned[2];
     ZobristKey pawnKey = 0ULL;
@@ -38,16 +36,32 @@ struct BoardState {
     ZobristKey blackNonPawnKey = 0ULL;
     ZobristKey posKey = 0ULL;
     int hisPly = 0;
+    uint16_t fiftyMove = 0;
+    uint16_t plyFromNull = 0;
+    uint8_t castlePerm = 15;
+    uint8_t enPas = 0;
+    uint8_t pieces[64];
+};
+
+// Squares attacked by each side, computed the first time they are asked for at a ply and kept until the board changes.
+// Sliders see through the king of the other side, so the map also tells that king which squares it can't step on
+struct AttackMaps {
+    Bitboard byPiece[2][6];
+    Bitboard all[2];
+    uint8_t valid = 0; // one bit per side
 };
 
 struct historyStack{
     BoardState    boardStateHistory[MAXPLY + 1];
+    // Kept next to the states instead of inside them so MakeMove doesn't have to copy them around
+    mutable AttackMaps attackMaps[MAXPLY + 1];
     int head = 0;
 
     void push(const BoardState& state) {
         assert(head < MAXPLY);
         head++;
         boardStateHistory[head] = state;
+        attackMaps[head].valid = 0;
     }
 
     void pop() {
@@ -56,11 +70,50 @@ struct historyStack{
     }
 };
 
+// Keys of the positions that came before the current one, both from the game and from the search
+struct KeyHistory {
+    ZobristKey keys[MAXGAMEPLY + MAXPLY];
+    int count = 0;
+
+    void push(const ZobristKey key) {
+        assert(count < MAXGAMEPLY + MAXPLY);
+        keys[count++] = key;
+    }
+
+    void pop() {
+        assert(count > 0);
+        count--;
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    // Only keeps the last n keys, making room for the rest of the game
+    void keepLast(const int n) {
+        if (n >= count)
+            return;
+        std::memmove(keys, keys + count - n, n * sizeof(ZobristKey));
+        count = n;
+    }
+
+    [[nodiscard]] int size() const {
+        return count;
+    }
+
+    [[nodiscard]] ZobristKey operator[](const int index) const {
+        assert(index >= 0 && index < count);
+        return keys[index];
+    }
+};
+
 struct Position {
 public:
     int side = -1; // what side has to move
     // stores the state of the board  rollback purposes
     historyStack history;
+    // stores the keys of the previous positions for repetition detection, pushed and popped along with history
+    KeyHistory keyHistory;
 
     [[nodiscard]] inline BoardState& state()  {
        return history.boardStateHistory[history.head];
@@ -80,7 +133,7 @@ public:
 
     // Retrieve a generic piece (useful when we don't know what type of piece we are dealing with
     [[nodiscard]] inline Bitboard getPieceColorBB(const int piecetype, const int color) const {
-        return state().bitboards[piecetype + color * 6];
+        return state().pieceTypeBB[piecetype] & state().occupancies[color];
     }
 
     [[nodiscard]] inline int PieceCount() const {
@@ -112,6 +165,10 @@ public:
         return state().plyFromNull;
     }
 
+    [[nodiscard]] inline AttackMaps& attackMaps() const {
+        return history.attackMaps[history.head];
+    }
+
     [[nodiscard]] inline Bitboard getCheckers() const {
         return state().checkers;
     }
@@ -125,7 +182,9 @@ public:
     }
 };
 
-extern Bitboard SQUARES_BETWEEN_BB[64][64];
+extern const std::array<std::array<Bitboard, 64>, 64> SQUARES_BETWEEN_BB;
+// The whole line (rank, file or diagonal) going through 2 squares, empty if they aren't aligned
+extern const std::array<std::array<Bitboard, 64>, 64> LINE_BB;
 
 // castling rights update constants
 constexpr int castling_rights[64] = {
@@ -160,14 +219,29 @@ constexpr char ascii_pieces[13] = "PNBRQKpnbrqk";
 void ParseFen(const std::string& command, Position* pos);
 // Get fen string from board
 [[nodiscard]] std::string GetFen(const Position* pos);
-// Parse a string of moves in coordinate format and plays them
-void parse_moves(const std::string& moves, Position* pos, std::vector<ZobristKey>& keyHistory);
+// Parse a list of moves in coordinate format and plays them
+void parse_moves(std::span<const std::string> moves, Position* pos);
 
 // Retrieve a generic piece (useful when we don't know what type of piece we are dealing with
 [[nodiscard]] Bitboard getPieceBB(const Position* pos, const int piecetype);
 
+// Returns the attack maps of <side>, computing them if the board changed since they were last asked for
+[[nodiscard]] const AttackMaps& GetAttackMaps(const Position* pos, const int side);
+
 // Returns the threats bitboard of the pieces of <side> color
-[[nodiscard]] Bitboard getThreats(const Position* pos, const int side);
+[[nodiscard]] inline Bitboard getThreats(const Position* pos, const int side) {
+    return GetAttackMaps(pos, side).all[side];
+}
+
+// Returns the threats bitboard of the pieces of <side> color and <piecetype> type
+[[nodiscard]] inline Bitboard getThreats(const Position* pos, const int side, const int piecetype) {
+    return GetAttackMaps(pos, side).byPiece[side][piecetype];
+}
+
+// Returns the piece a move of the side to move moves, moves don't carry it so it has to come from the board
+[[nodiscard]] inline int MovedPiece(const Position* pos, const Move move) {
+    return pos->PieceOn(From(move));
+}
 
 // Returns whether the opponent of <side> has a guaranteed SEE > 0
 [[nodiscard]] bool oppCanWinMaterial(const Position* pos, const int side);
@@ -190,4 +264,4 @@ Bitboard RayBetween(unsigned int square1, unsigned int square2);
 
 ZobristKey keyAfter(const Position* pos, const Move move);
 
-bool hasGameCycle(Position* pos, const std::vector<ZobristKey>& keyHistory, int ply);
+bool hasGameCycle(Position* pos, int ply);
@@ -2,22 +2,11 @@
 
 #include "types.h"
 
-// pseudo random number state
-inline uint64_t random_state = 6379633040001738036;
-
-// generate 64-bit pseudo legal numbers
-[[nodiscard]] inline uint64_t GetRandomU64Number(){
-    // get current state
-    uint64_t number = random_state;
-
+// generate 64-bit pseudo random numbers from a caller owned state, safe to use from multiple threads and at compile time
+[[nodiscard]] constexpr uint64_t GetRandomU64Number(uint64_t& state) {
     // XOR shift algorithm
-    number ^= number << 13;
-    number ^= number >> 7;
-    number ^= number << 17;
-
-    // update random number state
-    random_state = number;
-
-    // return random number
-    return number;
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
 }
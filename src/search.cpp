@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <iostream>
 #include "bitboard.h"
@@ -15,20 +17,21 @@
 #include "movegen.h"
 #include "time_manager.h"
 #include "io.h"
+#include "random.h"
 #include "types.h"
 
 // Returns true if the position is a 2-fold repetition, false otherwise
-static bool IsRepetition(const Position* pos, const std::vector<ZobristKey>& keyHistory) {
+static bool IsRepetition(const Position* pos) {
     assert(pos->state().hisPly >= pos->get50MrCounter());
     int counter = 0;
     // How many moves back should we look at most, aka our distance to the last irreversible move
-    int distance = std::min(pos->get50MrCounter(), pos->getPlyFromNull());
+    int distance = std::min({ pos->get50MrCounter(), pos->getPlyFromNull(), pos->keyHistory.size() });
     // Get the point our search should start from
-    auto startingPoint = keyHistory.size();
+    const int startingPoint = pos->keyHistory.size();
     // Scan backwards from the first position where a repetition is possible (4 half moves ago) for at most distance steps
     for (int index = 4; index <= distance; index += 2)
         // if we found the same position hashkey as the current position
-        if (keyHistory[startingPoint - index] == pos->getPoskey()) {
+        if (pos->keyHistory[startingPoint - index] == pos->getPoskey()) {
 
             // we found a 2-fold repetition within the search tree
             if (index < pos->history.head)
@@ -51,26 +54,19 @@ static bool Is50MrDraw(Position* pos) {
         if (!pos->getCheckers())
             return true;
 
-        // if we are in check make sure it's not checkmate
+        // if we are in check make sure it's not checkmate, we have at least one legal move if it's a draw
         MoveList moveList;
-        // generate moves
-        GenerateMoves(&moveList, pos, MOVEGEN_ALL);
-        for (int i = 0; i < moveList.count; i++) {
-            const Move move = moveList.moves[i].move;
-            if (IsLegal(pos, move)) {
-                return true; // We have at least one legal move, so it is a draw
-            }
-        }
-        return false; // We have no legal moves, it is checkmate
+        GenerateLegalMoves(&moveList, pos);
+        return moveList.count > 0;
     }
 
     return false;
 }
 
 // If we triggered any of the rules that forces a draw or we know the position is a draw return a draw score
-bool IsDraw(Position* pos, const std::vector<ZobristKey>& keyHistory) {
+bool IsDraw(Position* pos) {
     // if it's a 3-fold repetition, the fifty moves rule kicked in or there isn't enough material on the board to give checkmate then it's a draw
-    return IsRepetition(pos, keyHistory)
+    return IsRepetition(pos)
         || Is50MrDraw(pos);
 }
 
@@ -86,6 +82,15 @@ bool isDecisive(const int score) {
     return isMate(score) || isMated(score);
 }
 
+// The main thread of a normal search checks the limits for everyone and stops the helpers, the other threads that check their own limits search on their own
+[[nodiscard]] static bool ChecksLimits(const ThreadData* td) {
+    return td->id == 0 || td->deterministic || td->standalone;
+}
+
+[[nodiscard]] static bool StopsHelpers(const ThreadData* td) {
+    return td->id == 0 && !td->deterministic && !td->standalone;
+}
+
 // ClearForSearch handles the cleaning of the post and the info parameters to start search from a clean state
 void ClearForSearch(ThreadData* td) {
     // Extract data structures from ThreadData
@@ -96,15 +101,17 @@ void ClearForSearch(ThreadData* td) {
     info->nodes = 0;
     info->seldepth = 0;
 
-    // Main thread clears pvTable, nodeSpentTable, and unpauses any eventual search thread
+    // Main thread clears its pvTable and nodeSpentTable, and unpauses any eventual search thread
     if (td->id == 0) {
         // Clean the Pv array
-        std::memset(&pvTable, 0, sizeof(pvTable));
+        std::memset(&td->pvTable, 0, sizeof(td->pvTable));
         // Clean the node table
-        std::memset(nodeSpentTable, 0, sizeof(nodeSpentTable));
+        std::memset(td->nodeSpentTable, 0, sizeof(td->nodeSpentTable));
 
-        for (auto& helper_thread : threads_data)
-            helper_thread.info.stopped = false;
+        // A standalone thread has no helpers, the ones in threads_data belong to the uci search
+        if (!td->standalone)
+            for (auto& helper_thread : threads_data)
+                helper_thread.info.stopped = false;
     }
 }
 
@@ -121,6 +128,24 @@ static inline Bitboard AttacksTo(const Position* pos, const unsigned int to, Bit
          | (getRookAttacks(to, occ) & attackingRooks);
 }
 
+// Pieces that can take part in an exchange on the to square, pinned pieces only move along the line they are pinned on (diagonal counts as a line),
+// which includes capturing the pinning piece
+static inline Bitboard SEEAllowed(const Position* pos, const int to) {
+    const Bitboard whitePinned = pos->getPinnedMask(WHITE);
+    const Bitboard blackPinned = pos->getPinnedMask(BLACK);
+    const Bitboard whiteRay = RayBetween(KingSQ(pos, WHITE), to) | 1ULL << to;
+    const Bitboard blackRay = RayBetween(KingSQ(pos, BLACK), to) | 1ULL << to;
+    return ~(whitePinned | blackPinned) | (whitePinned & whiteRay) | (blackPinned & blackRay);
+}
+
+// The board once the moving piece (and the pawn captured en passant) left, it doesn't matter if the to square is occupied or not
+static inline Bitboard SEEOccupancy(const Position* pos, const Move move) {
+    Bitboard occupied = pos->Occupancy(BOTH) ^ (1ULL << From(move));
+    if (isEnpassant(move))
+        occupied ^= 1ULL << (To(move) + (pos->side == WHITE ? 8 : -8));
+    return occupied;
+}
+
 // inspired by the Weiss engine
 bool SEE(const Position* pos, const Move move, const int threshold) {
 
@@ -155,11 +180,16 @@ bool SEE(const Position* pos, const Move move, const int threshold) {
     if (value >= 0)
         return true;
 
-    // It doesn't matter if the to square is occupied or not
-    Bitboard occupied = pos->Occupancy(BOTH) ^ (1ULL << from);
-    if (isEnpassant(move))
-        occupied ^= pos->getEpSquare();
+    // If the opponent doesn't attack the square, and no slider of theirs can see it through the square we leave, nobody can recapture
+    if (!isEnpassant(move)) {
+        const int them = Color[attacker] ^ 1;
+        const AttackMaps& maps = GetAttackMaps(pos, them);
+        const Bitboard theirSliders = maps.byPiece[them][BISHOP] | maps.byPiece[them][ROOK] | maps.byPiece[them][QUEEN];
+        if (!(maps.all[them] & (1ULL << to)) && !(theirSliders & (1ULL << from)))
+            return true;
+    }
 
+    Bitboard occupied = SEEOccupancy(pos, move);
     Bitboard attackers = AttacksTo(pos, to, occupied);
 
     Bitboard bishops = getPieceBB(pos, BISHOP) | getPieceBB(pos, QUEEN);
@@ -167,16 +197,8 @@ bool SEE(const Position* pos, const Move move, const int threshold) {
 
     int side = Color[attacker] ^ 1;
 
-    const Bitboard whitePinned = pos->getPinnedMask(WHITE);
-    const Bitboard blackPinned = pos->getPinnedMask(BLACK);
-    const Bitboard pinnedPieces = whitePinned | blackPinned;
-
-    // allow limited movement for pinned pieces, as long as they move along the axis they are pinned on (diagonal counts as an axis) OR they capture the pinning piece
-    const Bitboard whiteRay = RayBetween(KingSQ(pos, WHITE), to) | 1ULL << to;
-    const Bitboard blackRay = RayBetween(KingSQ(pos, BLACK), to) | 1ULL << to;
-
     // mask out pinned pieces from attackers unless they can move over one axis
-    const Bitboard allowed = ~pinnedPieces | (whitePinned & whiteRay) | (blackPinned & blackRay);
+    const Bitboard allowed = SEEAllowed(pos, to);
 
     // Make captures until one side runs out, or fail to beat threshold
     while (true) {
@@ -216,11 +238,283 @@ bool SEE(const Position* pos, const Move move, const int threshold) {
     return side != Color[attacker];
 }
 
-Move GetBestMove() {
-    return pvTable.pvArray[0][0];
+// Returns the attackers of the to square on the current board, looking them up only the first time a capture lands there
+static inline Bitboard CachedAttacksTo(const Position* pos, const int to, SEECache* cache) {
+    if (!(cache->known & (1ULL << to))) {
+        cache->attackers[to] = AttacksTo(pos, to, pos->Occupancy(BOTH));
+        cache->known |= 1ULL << to;
+    }
+    return cache->attackers[to];
+}
+
+// Plays out the whole exchange once and returns its exact value, SEE(pos, move, threshold) is SEEScore(pos, move) >= threshold
+int SEEScore(const Position* pos, const Move move, SEECache* cache) {
+
+    // We can't win any material from castling, nor can we lose any
+    if (isCastle(move))
+        return 0;
+
+    const int to = To(move);
+    const int from = From(move);
+    const int attacker = pos->PieceOn(from);
+    const int target = isEnpassant(move) ? PAWN : pos->PieceOn(to);
+    const int promo = getPromotedPiecetype(move);
+
+    // gain[d] is the material won by the side making the d-th capture if the exchange stops right after it
+    int gain[32];
+    gain[0] = SEEValue[target];
+    if (isPromo(move))
+        gain[0] += SEEValue[promo] - SEEValue[PAWN];
+
+    // Same shortcut as SEE, if nobody can recapture we keep what we took
+    if (!isEnpassant(move)) {
+        const int them = Color[attacker] ^ 1;
+        const AttackMaps& maps = GetAttackMaps(pos, them);
+        const Bitboard theirSliders = maps.byPiece[them][BISHOP] | maps.byPiece[them][ROOK] | maps.byPiece[them][QUEEN];
+        if (!(maps.all[them] & (1ULL << to)) && !(theirSliders & (1ULL << from)))
+            return gain[0];
+    }
+
+    Bitboard occupied = SEEOccupancy(pos, move);
+    const Bitboard bishops = getPieceBB(pos, BISHOP) | getPieceBB(pos, QUEEN);
+    const Bitboard rooks = getPieceBB(pos, ROOK) | getPieceBB(pos, QUEEN);
+
+    Bitboard attackers;
+    if (cache && !isEnpassant(move)) {
+        attackers = CachedAttacksTo(pos, to, cache);
+        // The cached attackers still see the moving piece in the way of the sliders behind it
+        const bool diagonal = get_rank[from] != get_rank[to] && get_file[from] != get_file[to];
+        const Bitboard xraySliders = LINE_BB[from][to] & (diagonal ? bishops : rooks);
+        if (xraySliders)
+            attackers |= diagonal ? getBishopAttacks(to, occupied) & bishops : getRookAttacks(to, occupied) & rooks;
+    }
+    else
+        attackers = AttacksTo(pos, to, occupied);
+
+    const Bitboard allowed = SEEAllowed(pos, to);
+    int side = Color[attacker] ^ 1;
+    // The piece standing on the to square, which is what the next capture wins
+    int victim = isPromo(move) ? SEEValue[promo] : SEEValue[attacker];
+    int depth = 0;
+
+    while (true) {
+        // Remove used pieces from attackers
+        attackers &= occupied;
+
+        const Bitboard myAttackers = attackers & pos->Occupancy(side) & allowed;
+        if (!myAttackers)
+            break;
+
+        // Pick next least valuable piece to capture with
+        int pt;
+        for (pt = PAWN; pt < KING; ++pt)
+            if (myAttackers & getPieceBB(pos, pt))
+                break;
+
+        // The king can't capture a defended piece
+        if (pt == KING && (attackers & pos->Occupancy(side ^ 1)))
+            break;
+
+        ++depth;
+        gain[depth] = victim - gain[depth - 1];
+        victim = SEEValue[pt];
+
+        // Remove the used piece from occupied
+        occupied ^= 1ULL << (GetLsbIndex(myAttackers & pos->getPieceColorBB(pt, side)));
+
+        if (pt == PAWN || pt == BISHOP || pt == QUEEN)
+            attackers |= getBishopAttacks(to, occupied) & bishops;
+        if (pt == ROOK || pt == QUEEN)
+            attackers |= getRookAttacks(to, occupied) & rooks;
+
+        side ^= 1;
+    }
+
+    // Going backwards, each side only makes its capture if that's better than stopping the exchange before it
+    while (depth) {
+        gain[depth - 1] = std::min(gain[depth - 1], -gain[depth]);
+        --depth;
+    }
+    return gain[0];
+}
+
+// SEE check of a move the movepicker just returned, which comes with its exact SEE value if the movepicker had to compute it
+static inline bool PassesSEE(const Movepicker* mp, const Position* pos, const Move move, const int threshold) {
+    return mp->moveSEE != SCORE_NONE ? mp->moveSEE >= threshold : SEE(pos, move, threshold);
+}
+
+// Depths a mate search keeps iterating past the mate horizon before giving up
+constexpr int MATE_SEARCH_EXTRA_DEPTH = 4;
+
+// Skip blocks used to make helper threads skip some iterations of iterative deepening, so that they spread over more depths
+constexpr int skipSize[20]  = { 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4 };
+constexpr int skipPhase[20] = { 0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7 };
+
+// Returns true if the helper thread with the given id should skip searching the given depth
+static bool SkipDepth(const int id, const int depth) {
+    const int index = (id - 1) % 20;
+    return ((depth + skipPhase[index]) / skipSize[index]) % 2;
+}
+
+Move GetBestMove(const ThreadData* td) {
+    return td->pvTable.pvArray[0][0];
+}
+
+// Returns true if the search is allowed to look at the given root move
+static bool IsSearchMove(const SearchInfo* info, const Move move) {
+    return info->searchMoves.empty() || std::find(info->searchMoves.begin(), info->searchMoves.end(), move) != info->searchMoves.end();
+}
+
+// Returns the number of legal moves the search is allowed to look at in the root position
+static int CountRootMoves(ThreadData* td) {
+    MoveList moveList;
+    GenerateLegalMoves(&moveList, &td->pos);
+    int count = 0;
+    for (int i = 0; i < moveList.count; i++)
+        count += IsSearchMove(&td->info, moveList.moves[i]);
+    return count;
+}
+
+// Returns true if the move is the root move of one of the first pvIdx MultiPV lines of the depth being searched
+static bool IsPreviousPvMove(const Move move, const int pvIdx) {
+    for (int i = 0; i < pvIdx; i++)
+        if (multiPvLinesInProgress[i].moves[0] == move)
+            return true;
+    return false;
+}
+
+// Searches the best multiPV root moves one at a time, each line excluding the root moves of the lines found before it, returns the score of the best line
+// The lines of the last completed depth are only replaced if every line of this depth gets done, a search stopped halfway keeps reporting the old ones
+static int MultiPvSearch(const int depth, const int multiPV, const int prevScore, ThreadData* td) {
+    int score = 0;
+    for (int pvIdx = 0; pvIdx < multiPV; pvIdx++) {
+        td->pvIdx = pvIdx;
+        // Center the aspiration window around the score this line had at the previous depth, if it had one
+        const int lineScore = multiPvLines[pvIdx].score != SCORE_NONE ? multiPvLines[pvIdx].score : prevScore;
+        score = AspirationWindowSearch(lineScore, depth, td);
+
+        if (td->info.stopped)
+            break;
+
+        PvLine& line = multiPvLinesInProgress[pvIdx];
+        line.score = score;
+        line.length = td->pvTable.pvLength[0];
+        std::copy(td->pvTable.pvArray[0], td->pvTable.pvArray[0] + line.length, line.moves);
+        // The lines found so far are still the same set of root moves, so we can freely reorder them
+        std::stable_sort(multiPvLinesInProgress, multiPvLinesInProgress + pvIdx + 1, [](const PvLine& a, const PvLine& b) {
+            return a.score > b.score;
+        });
+    }
+
+    if (!td->info.stopped)
+        std::copy(multiPvLinesInProgress, multiPvLinesInProgress + multiPV, multiPvLines);
+
+    // Put the best line back in the pv table, that's where the rest of the search looks for the best move
+    if (td->pvIdx > 0) {
+        const PvLine& best = multiPvLinesInProgress[0];
+        td->pvTable.pvLength[0] = best.length;
+        std::copy(best.moves, best.moves + best.length, td->pvTable.pvArray[0]);
+        score = best.score;
+    }
+    td->pvIdx = 0;
+    return score;
+}
+
+// Prints the uci output of every MultiPV line, or just the pv table if we are searching a single line
+static void PrintSearchOutput(const int score, const int depth, const int multiPV, const ThreadData* td) {
+    // The output counts the nodes of the uci search threads, which a standalone thread has nothing to do with
+    if (td->standalone)
+        return;
+    if (multiPV == 1) {
+        PrintUciOutput(score, depth, td);
+        return;
+    }
+    for (int i = 0; i < multiPV; i++)
+        if (multiPvLines[i].score != SCORE_NONE)
+            PrintUciOutput(multiPvLines[i].score, depth, td, i + 1, &multiPvLines[i]);
+}
+
+// Returns the depth we can resume searching from if the root was reached by playing the first moves of the last search pv, 1 otherwise
+// resumePly is set to the number of pv moves played since, the pv has to go on past the root for us to have a move to fall back on
+static int GetResumeDepth(const ThreadData* td, int& resumeScore, int& resumePly) {
+    const KeyHistory& keyHistory = td->pos.keyHistory;
+    for (int played = 0; played < lastSearch.pvLength && played < lastSearch.depth; played++) {
+        if (lastSearch.pvKeys[played] != td->pos.getPoskey() || played > keyHistory.size())
+            continue;
+
+        // Make sure we actually played the pv moves to get here and didn't just transpose into the position
+        bool followsPv = true;
+        for (int i = 0; i < played; i++)
+            if (keyHistory[keyHistory.size() - played + i] != lastSearch.pvKeys[i])
+                followsPv = false;
+
+        if (followsPv) {
+            resumeScore = played % 2 ? -lastSearch.score : lastSearch.score;
+            resumePly = played;
+            return lastSearch.depth - played;
+        }
+    }
+    return 1;
+}
+
+// Saves the keys of the positions along the pv of the search that just ended
+static void SavePvKeys(ThreadData* td) {
+    Position* pos = &td->pos;
+    lastSearch.pvLength = td->pvTable.pvLength[0];
+    std::copy(td->pvTable.pvArray[0], td->pvTable.pvArray[0] + lastSearch.pvLength, lastSearch.pvMoves);
+    lastSearch.pvKeys[0] = pos->getPoskey();
+    for (int i = 0; i < lastSearch.pvLength; i++) {
+        MakeMove<true>(td->pvTable.pvArray[0][i], pos);
+        lastSearch.pvKeys[i + 1] = pos->getPoskey();
+    }
+    for (int i = 0; i < lastSearch.pvLength; i++)
+        UnmakeMove(pos);
+}
+
+// Waits for all the threads still searching to complete the depth, keepSearching is false if the thread is done
+// Returns whether the threads should search the next depth, which they only do if none of them is done and the search wasn't stopped
+static bool SyncDepth(const bool keepSearching) {
+    std::unique_lock<std::mutex> lock(searchBarrier.mutex);
+    if (!keepSearching)
+        searchBarrier.finished = true;
+    if (++searchBarrier.waiting == searchBarrier.count) {
+        searchBarrier.waiting = 0;
+        searchBarrier.goOn = !searchBarrier.finished;
+        searchBarrier.phase++;
+        searchBarrier.cv.notify_all();
+    }
+    else {
+        const uint64_t phase = searchBarrier.phase;
+        searchBarrier.cv.wait(lock, [&] { return searchBarrier.phase != phase || searchBarrier.stopped; });
+    }
+    // goOn can't change before every thread got back here, as changing it takes all of them
+    return searchBarrier.goOn && !searchBarrier.stopped;
+}
+
+// Takes a thread that is done searching out of the barrier, letting through the threads it was holding back
+static void LeaveSync() {
+    std::lock_guard<std::mutex> lock(searchBarrier.mutex);
+    searchBarrier.finished = true;
+    if (--searchBarrier.count > 0 && searchBarrier.waiting == searchBarrier.count) {
+        searchBarrier.waiting = 0;
+        searchBarrier.goOn = false;
+        searchBarrier.phase++;
+        searchBarrier.cv.notify_all();
+    }
+}
+
+// Picks the thread whose result a deterministic search plays: the one that completed the most depths, then the one with the best score
+// Going through the threads in order of id and only replacing on strictly better results makes the choice the same on every run
+static const ThreadData* PickDeterministicResult(const ThreadData* td) {
+    const ThreadData* best = td;
+    for (const auto& helper : threads_data) {
+        if (   helper.completedDepth > best->completedDepth
+            || (helper.completedDepth == best->completedDepth && helper.completedScore > best->completedScore))
+            best = &helper;
+    }
+    return best;
 }
 
-// Starts the search process, this is ideally the point where you can start a multithreaded search
 void RootSearch(int depth, ThreadData* td, UciOptions* options) {
     // Init a thread_data object for each helper thread that doesn't have one already
     for (int i = threads_data.size(); i < options->Threads - 1; i++) {
@@ -228,59 +522,149 @@ void RootSearch(int depth, ThreadData* td, UciOptions* options) {
         threads_data.back().id = i + 1;
     }
 
+    // In analysis mode pick up the search from where the last one got to along its pv
+    int resumeScore = SCORE_NONE;
+    int resumePly = 0;
+    const int resumeDepth = options->UCI_AnalyseMode && td->info.searchMoves.empty() ? std::min(GetResumeDepth(td, resumeScore, resumePly), depth) : 1;
+    td->resumeScore = resumeScore;
+    // Until this search completes a depth, the depth we resume from is all we know about the position
+    lastSearch.depth = resumeDepth - 1;
+    lastSearch.score = resumeScore;
+
+    // In deterministic mode every thread searches the same depths on its own slice of the TT, with its own node budget
+    // Nothing a thread finds then depends on how the threads get scheduled, but anything but the node count could stop a thread at a different point from one run to the next
+    const bool nodesOnly = td->info.nodeset && !td->info.timeset && !td->info.movetimeset && !td->info.ponder;
+    const bool deterministic = options->Deterministic && options->Threads > 1 && nodesOnly;
+    if (options->Deterministic && options->Threads > 1 && !nodesOnly)
+        std::cout << "info string Deterministic needs a search limited by nodes only, searching normally" << std::endl;
+    if (deterministic) {
+        searchBarrier.count = options->Threads;
+        searchBarrier.waiting = 0;
+        searchBarrier.goOn = true;
+        searchBarrier.finished = false;
+        searchBarrier.stopped = false;
+        // The slices are views of the TT, so the whole table is aged once before handing them out
+        UpdateTableAge();
+        td->ttSlice = GetTTSlice(0, options->Threads);
+    }
+    td->tt = deterministic ? &td->ttSlice : &TT;
+    td->deterministic = deterministic;
+
     // Init thread_data objects
     for (size_t i = 0; i < threads_data.size(); i++) {
         threads_data[i].info = td->info;
         threads_data[i].pos = td->pos;
-        threads_data[i].keyHistory = td->keyHistory;
+        // Diversify the helpers, as they can only profit from sharing the TT if they don't all search the same tree
+        threads_data[i].aspDeltaOffset = (threads_data[i].id % 4) * options->SMPAspDelta;
+        threads_data[i].rootNoise = options->SMPRootNoise;
+        threads_data[i].useBreadcrumbs = options->SMPBreadcrumbs && options->Threads > 1 && !deterministic;
+        threads_data[i].resumeScore = resumeScore;
+        threads_data[i].skipDepths = options->SMPSkipDepths && !deterministic;
+        threads_data[i].deterministic = deterministic;
+        if (deterministic)
+            threads_data[i].ttSlice = GetTTSlice(threads_data[i].id, options->Threads);
+        threads_data[i].tt = deterministic ? &threads_data[i].ttSlice : &TT;
     }
+    td->useBreadcrumbs = options->SMPBreadcrumbs && options->Threads > 1 && !deterministic;
 
-    // Start Threads-1 helper search threads
-    for (int i = 0; i < options->Threads - 1; i++)
-        threads.emplace_back(SearchPosition, 1, depth, &threads_data[i], options);
+    // Start Threads-1 helper search threads, each one starting from a (possibly) different depth
+    for (int i = 0; i < options->Threads - 1; i++) {
+        const int startDepth = deterministic ? resumeDepth : resumeDepth + threads_data[i].id % (options->SMPDepthOffset + 1);
+        threads.emplace_back(SearchPosition, std::min(startDepth, depth), depth, &threads_data[i], options);
+    }
 
     // MainThread search
-    SearchPosition(1, depth, td, options);
-    // Stop helper threads before returning the best move
-    StopHelperThreads();
-    // Print final bestmove found
+    SearchPosition(resumeDepth, depth, td, options);
+    // Stop helper threads before returning the best move, in deterministic mode they stop on their own once they are done with their depth
+    if (deterministic)
+        JoinHelperThreads();
+    else
+        StopHelperThreads();
+    // A resumed search stopped before it completed a depth falls back on what is left of the pv it resumed along
+    if (resumeDepth > 1 && td->completedDepth == 0) {
+        td->pvTable.pvLength[0] = lastSearch.pvLength - resumePly;
+        std::copy(lastSearch.pvMoves + resumePly, lastSearch.pvMoves + lastSearch.pvLength, td->pvTable.pvArray[0]);
+    }
+    if (options->UCI_AnalyseMode)
+        SavePvKeys(td);
+    // When pondering we aren't allowed to send the bestmove until the gui sends either a ponderhit or a stop
+    td->info.ponder.wait(true);
+    // Print final bestmove found, along with the reply we expect from the opponent if we have one
+    const ThreadData* bestThread = deterministic ? PickDeterministicResult(td) : td;
     std::cout << "bestmove ";
-    PrintMove(GetBestMove());
+    PrintMove(GetBestMove(bestThread));
+    if (bestThread->pvTable.pvLength[0] > 1) {
+        std::cout << " ponder ";
+        PrintMove(bestThread->pvTable.pvArray[0][1]);
+    }
     std::cout << std::endl;
+    // Wake up anyone waiting for the search to be over
+    SignalSearchDone();
 }
 
 // SearchPosition is the actual function that handles the search, it sets up the variables needed for the search, calls the AspirationWindowSearch function and handles the console output
 void SearchPosition(int startDepth, int finalDepth, ThreadData* td, UciOptions* options) {
     // variable used to store the score of the best move found by the search (while the move itself can be retrieved from the triangular PV table)
     int score = 0;
-    int prevScore = 0;
-    int averageScore = SCORE_NONE;
+    // When resuming a search we already have an idea of what the score is going to be
+    const bool resumed = td->resumeScore != SCORE_NONE;
+    int prevScore = resumed ? td->resumeScore : 0;
+    int averageScore = td->resumeScore;
     int bestMoveStabilityFactor = 0;
     int evalStabilityFactor = 0;
     Move previousBestMove = NOMOVE;
 
     // Clean the position and the search info to start search from a clean state
     ClearForSearch(td);
-    UpdateTableAge();
+    td->completedScore = 0;
+    td->completedDepth = 0;
+    // A deterministic search ages the TT before splitting it among the threads
+    if (!td->deterministic)
+        UpdateTableAge(td->tt);
     bool printFinalInfoString = false;
     bool shortUCI = options->shortUci;
 
-    std::memset(td->sd.rootHistory, 0, sizeof(td->sd.rootHistory));
+    // The root statistics are only kept when resuming the search of a previous root
+    if (!resumed)
+        std::memset(td->sd.rootHistory, 0, sizeof(td->sd.rootHistory));
+
+    // Helper threads can start with some noise in the root history to perturb the root move ordering
+    if (td->id != 0 && td->rootNoise && !resumed) {
+        uint64_t seed = 0x9E3779B97F4A7C15ULL * td->id;
+        for (auto& side : td->sd.rootHistory)
+            for (auto& entry : side)
+                entry = static_cast<int>(GetRandomU64Number(seed) % (2 * td->rootNoise + 1)) - td->rootNoise;
+    }
+
+    // A mate search has nothing to find past the mate horizon, the few extra depths only make up for the plies that reductions take away
+    if (td->info.mate)
+        finalDepth = std::min(finalDepth, 2 * td->info.mate - 1 + MATE_SEARCH_EXTRA_DEPTH);
+
+    // Only the main thread looks for more than one line, and never for more lines than there are legal root moves
+    const int multiPV = td->id == 0 && !td->standalone ? std::min(options->MultiPV, CountRootMoves(td)) : 1;
+    if (multiPV > 1)
+        for (int i = 0; i < MAXMULTIPV; i++)
+            multiPvLines[i] = multiPvLinesInProgress[i] = PvLine();
 
     // Call the Negamax function in an iterative deepening framework
     for (int currentDepth = startDepth; currentDepth <= finalDepth; currentDepth++) {
-        score = AspirationWindowSearch(averageScore, currentDepth, td);
+        // Helpers may skip some depths so that the threads end up searching different depths at the same time
+        if (td->id != 0 && td->skipDepths && currentDepth < finalDepth && SkipDepth(td->id, currentDepth))
+            continue;
+
+        score = multiPV > 1 ? MultiPvSearch(currentDepth, multiPV, averageScore, td)
+                            : AspirationWindowSearch(averageScore, currentDepth, td);
         averageScore = averageScore == SCORE_NONE ? score : (averageScore + score) / 2;
 
         // Only the main thread handles time related tasks
         if (td->id == 0) {
             // Keep track of how many times in a row the best move stayed the same
-            if (GetBestMove() == previousBestMove) {
+            if (GetBestMove(td) == previousBestMove) {
                 bestMoveStabilityFactor = std::min(bestMoveStabilityFactor + 1, 4);
             }
             else {
                 bestMoveStabilityFactor = 0;
-                previousBestMove = GetBestMove();
+                previousBestMove = GetBestMove(td);
             }
 
             // Keep track of eval stability
@@ -293,7 +677,8 @@ void SearchPosition(int startDepth, int finalDepth, ThreadData* td, UciOptions*
 
             // use the previous search to adjust some of the time management parameters, do not scale movetime time controls
             if (   td->RootDepth > 7
-                && td->info.timeset) {
+                && td->info.timeset
+                && !td->info.ponder.load(std::memory_order_acquire)) {
                 ScaleTm(td, bestMoveStabilityFactor, evalStabilityFactor);
             }
 
@@ -308,7 +693,7 @@ void SearchPosition(int startDepth, int finalDepth, ThreadData* td, UciOptions*
 
         // Print a final info string if we have to
         if (td->id == 0 && printFinalInfoString)
-            PrintUciOutput(prevScore, currentDepth - 1, td, options);
+            PrintSearchOutput(prevScore, currentDepth - 1, multiPV, td);
 
         // stop calculating and return best move so far
         if (td->info.stopped)
@@ -316,12 +701,36 @@ void SearchPosition(int startDepth, int finalDepth, ThreadData* td, UciOptions*
 
         // If it's the main thread print the uci output
         if (td->id == 0 && (!shortUCI || currentDepth == finalDepth))
-            PrintUciOutput(score, currentDepth, td, options);
+            PrintSearchOutput(score, currentDepth, multiPV, td);
+
+        // Keep track of the result of the last completed depth
+        td->completedScore = score;
+        td->completedDepth = currentDepth;
+
+        // Remember the last depth the main thread completed, analysis mode resumes the next search from there
+        if (td->id == 0 && !td->standalone && options->UCI_AnalyseMode) {
+            lastSearch.depth = currentDepth;
+            lastSearch.score = score;
+        }
+
+        // In mate search mode we are done as soon as we proved a short enough mate
+        if (   td->id == 0
+            && td->info.mate
+            && score > MATE_FOUND
+            && (MATE_SCORE - score) / 2 + 1 <= td->info.mate)
+            break;
 
         // Seldepth should only be related to the current ID loop
         td->info.seldepth = 0;
         prevScore = score;
+
+        // In deterministic mode the threads wait for each other before going deeper, and all stop together once one of them is done
+        if (td->deterministic && currentDepth < finalDepth && !SyncDepth(!NodesOver(&td->info)))
+            break;
     }
+
+    if (td->deterministic)
+        LeaveSync();
 }
 
 int AspirationWindowSearch(int prev_eval, int depth, ThreadData* td) {
@@ -334,16 +743,18 @@ int AspirationWindowSearch(int prev_eval, int depth, ThreadData* td) {
         (ss + i)->move = NOMOVE;
         (ss + i)->excludedMove = NOMOVE;
         (ss + i)->searchKiller = NOMOVE;
+        (ss + i)->killerPiece = EMPTY;
         (ss + i)->staticEval = SCORE_NONE;
-        (ss + i)->contHistEntry = &sd->contHist[PieceTo(NOMOVE)];
+        (ss + i)->movedPiece = WP;
+        (ss + i)->contHistEntry = &sd->contHist[PieceTo(WP, NOMOVE)];
         (ss + i)->reduction = 0;
     }
     for (int i = 0; i < MAXDEPTH; i++) {
         (ss + i)->ply = i;
-        (ss + i)->contHistEntry = &sd->contHist[PieceTo(NOMOVE)];
+        (ss + i)->contHistEntry = &sd->contHist[PieceTo(WP, NOMOVE)];
     }
     // We set an expected window for the score at the next search depth, this window is not 100% accurate so we might need to try a bigger window and re-search the position
-    int delta = aspWinDelta() + prev_eval * prev_eval / aspWinPrevevalDiv();
+    int delta = aspWinDelta() + td->aspDeltaOffset + prev_eval * prev_eval / aspWinPrevevalDiv();
     // define initial alpha beta bounds
     int alpha = -MAXSCORE;
     int beta = MAXSCORE;
@@ -359,8 +770,9 @@ int AspirationWindowSearch(int prev_eval, int depth, ThreadData* td) {
         score = Negamax<true>(alpha, beta, depth, false, td, ss);
 
         // Check if more than Maxtime passed and we have to stop
-        if (td->id == 0 && TimeOver(&td->info)) {
-            StopHelperThreads();
+        if (ChecksLimits(td) && TimeOver(&td->info)) {
+            if (StopsHelpers(td))
+                StopHelperThreads();
             td->info.stopped = true;
             break;
         }
@@ -388,6 +800,47 @@ int AspirationWindowSearch(int prev_eval, int depth, ThreadData* td) {
     return score;
 }
 
+// Breadcrumbs mark the positions close to the root that are currently being searched by a thread, in the spirit of ABDADA
+struct Breadcrumb {
+    std::atomic<int> thread;
+    std::atomic<ZobristKey> key;
+};
+
+static std::array<Breadcrumb, 1024> breadcrumbs;
+
+// Marks a position as being searched by the current thread for as long as the object is alive, and tells us if another thread was already searching it
+struct ThreadHolding {
+    ThreadHolding(const ThreadData* td, const ZobristKey posKey, const int ply) {
+        location = td->useBreadcrumbs && ply < 8 ? &breadcrumbs[posKey & (breadcrumbs.size() - 1)] : nullptr;
+        otherThread = false;
+        owning = false;
+        if (location) {
+            // See if another already marked this location, if not, mark it ourselves
+            const int holder = location->thread.load(std::memory_order_relaxed);
+            if (holder == 0) {
+                location->thread.store(td->id + 1, std::memory_order_relaxed);
+                location->key.store(posKey, std::memory_order_relaxed);
+                owning = true;
+            }
+            else if (   holder != td->id + 1
+                     && location->key.load(std::memory_order_relaxed) == posKey)
+                otherThread = true;
+        }
+    }
+
+    ~ThreadHolding() {
+        // Free the marked location
+        if (owning)
+            location->thread.store(0, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] bool marked() const { return otherThread; }
+
+private:
+    Breadcrumb* location;
+    bool otherThread, owning;
+};
+
 int futilityMargin(const int depth, const bool improving, const bool canIIR){
     return rfpDepthMargin() * depth - rfpImprovingMargin() * improving - rfpIIRMargin() * canIIR;
 }
@@ -399,7 +852,8 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
     Position* pos = &td->pos;
     SearchData* sd = &td->sd;
     SearchInfo* info = &td->info;
-    const bool mainT = td->id == 0;
+    // Only the main thread keeps track of the pv, unless any thread can end up providing the bestmove
+    const bool mainT = td->id == 0 || td->deterministic;
 
     // Initialize the node
     const bool inCheck = pos->getCheckers();
@@ -414,15 +868,16 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
     // if we are in a singular search and reusing the same ss entry, we have to guard this statement otherwise the pv length will get reset
     if (mainT)
-        pvTable.pvLength[ss->ply] = ss->ply;
+        td->pvTable.pvLength[ss->ply] = ss->ply;
 
     // Check for the highest depth reached in search to report it to the cli
     if (ss->ply > info->seldepth)
         info->seldepth = ss->ply;
 
     // check if more than Maxtime passed and we have to stop
-    if (mainT && TimeOver(&td->info)) {
-        StopHelperThreads();
+    if (ChecksLimits(td) && TimeOver(&td->info)) {
+        if (StopsHelpers(td))
+            StopHelperThreads();
         td->info.stopped = true;
         return 0;
     }
@@ -433,11 +888,11 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
     // Check for early return conditions
     if (!rootNode) {
         // If position is a draw return a draw score
-        if (IsDraw(pos, td->keyHistory))
+        if (IsDraw(pos))
             return (info->nodes & 2) - 1;
 
         // Upcoming repetition detection
-        if (alpha < 0 && hasGameCycle(pos, td->keyHistory, ss->ply))
+        if (alpha < 0 && hasGameCycle(pos, ss->ply))
         {
             alpha = 0;
             if (alpha >= beta)
@@ -453,6 +908,12 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         // If we reached maxdepth we return a static evaluation of the position
         if (ss->ply >= MAXDEPTH - 1)
             return inCheck ? 0 : EvalPosition(pos, &td->FTable);
+
+        // When looking for a mate in N our last mating move is played at ply 2N - 2, so the only node past that point that still matters is a possible checkmate at ply 2N - 1
+        if (   info->mate
+            && ss->ply >= 2 * info->mate - 1
+            && (ss->ply > 2 * info->mate - 1 || !inCheck))
+            return inCheck ? 0 : EvalPosition(pos, &td->FTable);
     }
 
     // recursion escape condition
@@ -460,9 +921,9 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         return Quiescence<pvNode>(alpha, beta, 0, td, ss);
 
     // Probe the TT for useful previous search information, we avoid doing so if we are searching a singular extension
-    const bool ttHit = !excludedMove && ProbeTTEntry(pos->getPoskey(), &tte);
+    const bool ttHit = !excludedMove && ProbeTTEntry(pos->getPoskey(), &tte, td->tt);
     const int ttScore = ttHit ? ScoreFromTT(tte.score, ss->ply) : SCORE_NONE;
-    const Move ttMove = ttHit ? MoveFromTT(pos, tte.move) : NOMOVE;
+    const Move ttMove = ttHit ? tte.move : NOMOVE;
     const uint8_t ttBound = ttHit ? BoundFromTT(tte.ageBoundPV) : uint8_t(HFNONE);
     const uint8_t ttDepth = tte.depth;
     const auto ttEval = tte.eval;
@@ -476,7 +937,7 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         && (ttBound & (ttScore >= beta ? HFLOWER : HFUPPER))) {
         if (ttMove && ttScore >= beta && (ss-1)->moveCount < 4 && isQuiet((ss-1)->move)) {
             if ((ss-1)->move != NOMOVE) {
-                updateCHScore((ss-1), (ss-1)->move, -std::min(conthistoryTTMalusMul() * depth, conthistoryTTMalusMax()));
+                updateCHScore((ss-1), (ss-1)->movedPiece, (ss-1)->move, -std::min(conthistoryTTMalusMul() * depth, conthistoryTTMalusMax()));
             }
         }
         return ttScore;
@@ -514,7 +975,7 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         auto correction = GetCorrHistAdjustment(pos, sd, ss);
         eval = ss->staticEval = adjustEval(pos,correction,  rawEval);
         // Save the eval into the TT
-        StoreTTEntry(pos->getPoskey(), NOMOVE, SCORE_NONE, rawEval, HFNONE, 0, pvNode, ttPv);
+        StoreTTEntry(pos->getPoskey(), NOMOVE, SCORE_NONE, rawEval, HFNONE, 0, pvNode, ttPv, td->tt);
     }
 
     // Use static evaluation difference to improve quiet move ordering (~6 Elo)
@@ -545,9 +1006,11 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         return true;
     }();
 
+    // A mate search can't trust the static eval to tell it where the mates aren't, so it skips the eval based pruning
     if (!pvNode
         && !excludedMove
-        && !inCheck) {
+        && !inCheck
+        && !info->mate) {
 
         // Hindsight reduction
         if( depth >= 2 && (ss-1)->reduction >= 1 && (ss-1)->staticEval != SCORE_NONE && ss->staticEval + (ss-1)->staticEval >= hindsightEval()){
@@ -573,15 +1036,15 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
             ss->move = NOMOVE;
             const int R = 4 + depth / 3 + std::min((eval - beta) / nmpReductionEvalDivisor(), 3);
-            ss->contHistEntry = &sd->contHist[PieceTo(NOMOVE)];
+            ss->contHistEntry = &sd->contHist[PieceTo(WP, NOMOVE)];
 
-            TTPrefetch(keyAfter(pos, NOMOVE));
-            MakeNullMove(pos, td->keyHistory);
+            TTPrefetch(keyAfter(pos, NOMOVE), td->tt);
+            MakeNullMove(pos);
 
             // Search moves at a reduced depth to find beta cutoffs.
             int nmpScore = -Negamax<false>(-beta, -beta + 1, depth - R - badNode, !cutNode, td, ss + 1);
 
-            TakeNullMove(pos, td->keyHistory);
+            TakeNullMove(pos);
 
             // fail-soft beta cutoff
             if (nmpScore >= beta) {
@@ -614,6 +1077,7 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
     const int pcBeta = beta + probcutBaseMargin() - probcutImprovingOffset() * improving;
     if (  !pvNode
+        && !info->mate
         && depth > 4
         && !isDecisive(beta)
         && (ttScore == SCORE_NONE || (ttBound & HFLOWER))
@@ -631,16 +1095,17 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
                 continue;
 
             // Speculative prefetch of the TT entry
-            TTPrefetch(keyAfter(pos, move));
+            TTPrefetch(keyAfter(pos, move), td->tt);
 
             ss->move = move;
-            ss->contHistEntry = &sd->contHist[PieceTo(move)];
+            ss->movedPiece = MovedPiece(pos, move);
+            ss->contHistEntry = &sd->contHist[PieceTo(ss->movedPiece, move)];
 
             // increment nodes count
             info->nodes++;
 
             // Play the move
-            MakeMove<true>(move, pos, td->keyHistory);
+            MakeMove<true>(move, pos);
 
             int pcScore = -Quiescence<false>(-pcBeta, -pcBeta + 1, 0, td, ss + 1);
             if (pcScore >= pcBeta)
@@ -648,12 +1113,12 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
                                           !cutNode, td, ss + 1);
 
             // Take move back
-            UnmakeMove(pos, td->keyHistory);
+            UnmakeMove(pos);
 
             if (pcScore >= pcBeta) {
-                StoreTTEntry(pos->getPoskey(), MoveToTT(move),
+                StoreTTEntry(pos->getPoskey(), move,
                              ScoreToTT(pcScore, ss->ply), rawEval, HFLOWER,
-                             depth - 3, pvNode, ttPv);
+                             depth - 3, pvNode, ttPv, td->tt);
                 return pcScore;
             }
         }
@@ -677,6 +1142,9 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
     Movepicker mp;
     InitMP(&mp, pos, sd, ss, ttMove, SCORE_NONE,SEARCH, rootNode);
 
+    // Mark this node as being searched by us, if another thread is already on it we'll reduce our moves more to spread the threads over different subtrees
+    const ThreadHolding th(td, pos->getPoskey(), ss->ply);
+
     // Keep track of the played quiet and noisy moves
     StackMoveList quietMoves, noisyMoves;
 
@@ -686,14 +1154,20 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         if (move == excludedMove || !IsLegal(pos, move))
             continue;
 
+        // Leave out the root moves excluded by searchmoves and, in MultiPV mode, the ones of the lines we already found
+        if (   rootNode
+            && (!IsSearchMove(info, move) || (td->pvIdx && IsPreviousPvMove(move, td->pvIdx))))
+            continue;
+
         // Speculative prefetch of the TT entry
-        TTPrefetch(keyAfter(pos, move));
+        TTPrefetch(keyAfter(pos, move), td->tt);
         ss->moveCount = ++totalMoves;
 
         const bool isQuiet = !isTactical(move);
 
         const int moveHistory = GetHistoryScoreSearch(pos, sd, move, ss, false);
         if (   !rootNode
+            && !info->mate
             && !isMated(bestScore)) {
 
             const int reduction = reductions[isQuiet][std::min(depth, 63)][std::min(totalMoves, 63)];
@@ -726,7 +1200,7 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
             }
             int see_margin = isQuiet ? seeQuietMargin() * lmrDepth : seeNoisyMargin() * lmrDepth * lmrDepth;
             // See pruning: prune all the moves that have a SEE score that is lower than our threshold
-            if (!SEE(pos, move, see_margin))
+            if (!PassesSEE(&mp, pos, move, see_margin))
                 continue;
         }
 
@@ -775,9 +1249,10 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
         int newDepth = depth - 1 + extension;
 
         ss->move = move;
+        ss->movedPiece = MovedPiece(pos, move);
         // Play the move
-        MakeMove<true>(move, pos, td->keyHistory);
-        ss->contHistEntry = &sd->contHist[PieceTo(move)];
+        MakeMove<true>(move, pos);
+        ss->contHistEntry = &sd->contHist[PieceTo(ss->movedPiece, move)];
 
         // increment nodes count
         info->nodes++;
@@ -814,6 +1289,10 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
                 // Decrease the reduction for moves that have a good history score and increase it for moves with a bad score
                 depthReduction -= moveHistory / historyQuietLmrDivisor();
+
+                // Reduce more if another thread is searching this node
+                if (th.marked())
+                    depthReduction += 1;
             }
             else {
                 // Fuck
@@ -852,7 +1331,7 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
                 int bonus = score > alpha ? history_bonus(depth)
                                           : -history_malus(depth);
-                updateCHScore(ss, move, bonus);
+                updateCHScore(ss, ss->movedPiece, move, bonus);
             }
         }
         // If we skipped LMR and this isn't the first move of the node we'll search with a reduced window and full depth
@@ -865,9 +1344,9 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
             score = -Negamax<true>(-beta, -alpha, newDepth, false, td, ss + 1);
 
         // take move back
-        UnmakeMove(pos, td->keyHistory);
+        UnmakeMove(pos);
         if (mainT && rootNode)
-            nodeSpentTable[FromTo(move)] += info->nodes - nodesBeforeSearch;
+            td->nodeSpentTable[FromTo(move)] += info->nodes - nodesBeforeSearch;
 
         if (info->stopped)
             return 0;
@@ -883,21 +1362,24 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
 
                 if (pvNode && mainT) {
                     // Update the pv table
-                    pvTable.pvArray[ss->ply][ss->ply] = move;
-                    for (int nextPly = ss->ply + 1; nextPly < pvTable.pvLength[ss->ply + 1]; nextPly++) {
-                        pvTable.pvArray[ss->ply][nextPly] = pvTable.pvArray[ss->ply + 1][nextPly];
+                    td->pvTable.pvArray[ss->ply][ss->ply] = move;
+                    for (int nextPly = ss->ply + 1; nextPly < td->pvTable.pvLength[ss->ply + 1]; nextPly++) {
+                        td->pvTable.pvArray[ss->ply][nextPly] = td->pvTable.pvArray[ss->ply + 1][nextPly];
                     }
-                    pvTable.pvLength[ss->ply] = pvTable.pvLength[ss->ply + 1];
+                    td->pvTable.pvLength[ss->ply] = td->pvTable.pvLength[ss->ply + 1];
                 }
 
                 if (score >= beta) {
                     // If the move that caused the beta cutoff is quiet we have a killer move
                     if (isQuiet) {
                         ss->searchKiller = bestMove;
+                        ss->killerPiece = ss->movedPiece;
 
                         // Save counterMoves
-                        if (ss->ply >= 1)
+                        if (ss->ply >= 1) {
                             sd->counterMoves[FromTo((ss - 1)->move)] = move;
+                            sd->counterPieces[FromTo((ss - 1)->move)] = ss->movedPiece;
+                        }
                     }
                     // Update the history heuristics based on the new best move
                     UpdateHistories(pos, sd, ss, depth + (eval <= alpha), bestMove, &quietMoves, &noisyMoves, rootNode);
@@ -924,18 +1406,21 @@ int Negamax(int alpha, int beta, int depth, const bool cutNode, ThreadData* td,
              :      inCheck ? -MATE_SCORE + ss->ply
                             : 0;
     }
+
     // Set the TT bound based on whether we failed high or raised alpha
     int bound = bestScore >= beta ? HFLOWER : alpha != old_alpha ? HFEXACT : HFUPPER;
 
+    // A mate search cuts the tree off at the mate horizon, so its scores aren't real bounds that later searches could use
     if (    !inCheck
+        && !info->mate
         && (!bestMove || !isTactical(bestMove))
         &&  !(bound == HFLOWER && bestScore <= ss->staticEval)
         &&  !(bound == HFUPPER && bestScore >= ss->staticEval)) {
         updateCorrHistScore(pos, sd, ss, depth, bestScore - ss->staticEval);
     }
 
-    if (!excludedMove) {
-        StoreTTEntry(pos->getPoskey(), MoveToTT(bestMove), ScoreToTT(bestScore, ss->ply), rawEval, bound, depth, pvNode, ttPv);
+    if (!excludedMove && !info->mate) {
+        StoreTTEntry(pos->getPoskey(), bestMove, ScoreToTT(bestScore, ss->ply), rawEval, bound, depth, pvNode, ttPv, td->tt);
     }
 
     return bestScore;
@@ -954,8 +1439,9 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
     int rawEval;
 
     // check if more than Maxtime passed and we have to stop
-    if (td->id == 0 && TimeOver(&td->info)) {
-        StopHelperThreads();
+    if (ChecksLimits(td) && TimeOver(&td->info)) {
+        if (StopsHelpers(td))
+            StopHelperThreads();
         td->info.stopped = true;
         return 0;
     }
@@ -965,7 +1451,7 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
         return inCheck ? 0 : EvalPosition(pos,&td->FTable);
 
     // Upcoming repetition detection
-    if (alpha < 0 && hasGameCycle(pos, td->keyHistory, ss->ply))
+    if (alpha < 0 && hasGameCycle(pos, ss->ply))
     {
         alpha = 0;
         if (alpha >= beta)
@@ -976,9 +1462,9 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
         return 0;
 
     // ttHit is true if and only if we find something in the TT
-    const bool ttHit = ProbeTTEntry(pos->getPoskey(), &tte);
+    const bool ttHit = ProbeTTEntry(pos->getPoskey(), &tte, td->tt);
     const int ttScore = ttHit ? ScoreFromTT(tte.score, ss->ply) : SCORE_NONE;
-    const Move ttMove = ttHit ? MoveFromTT(pos, tte.move) : NOMOVE;
+    const Move ttMove = ttHit ? tte.move : NOMOVE;
     const uint8_t ttBound = ttHit ? BoundFromTT(tte.ageBoundPV) : uint8_t(HFNONE);
     // If we found a value in the TT for this position, we can return it (pv nodes are excluded)
     if (   !pvNode
@@ -1010,7 +1496,7 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
             rawEval = EvalPosition(pos, &td->FTable);
             auto correction = GetCorrHistAdjustment(pos, sd, ss);
             bestScore = ss->staticEval = adjustEval(pos,correction,  rawEval);
-            StoreTTEntry(pos->getPoskey(), NOMOVE, SCORE_NONE, rawEval, HFNONE, 0, false, ttPv);
+            StoreTTEntry(pos->getPoskey(), NOMOVE, SCORE_NONE, rawEval, HFNONE, 0, false, ttPv, td->tt);
         }
 
         // Stand pat
@@ -1046,27 +1532,28 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
         // Futility pruning. If static eval is far below alpha, only search moves that win material.
         if (!isMated(bestScore)) {
             const int futilityBase = ss->staticEval + qsBaseFutility();
-            if (!inCheck && futilityBase <= alpha && !SEE(pos, move, 1)) {
+            if (!inCheck && futilityBase <= alpha && !PassesSEE(&mp, pos, move, 1)) {
                 bestScore = std::max(futilityBase, bestScore);
                 continue;
             }
 
-            if (!SEE(pos, move, qsSEEmargin())) {
+            if (!PassesSEE(&mp, pos, move, qsSEEmargin())) {
                 continue;
             }
         }
         // Speculative prefetch of the TT entry
-        TTPrefetch(keyAfter(pos, move));
+        TTPrefetch(keyAfter(pos, move), td->tt);
         ss->move = move;
+        ss->movedPiece = MovedPiece(pos, move);
         // Play the move
-        MakeMove<true>(move, pos, td->keyHistory);
+        MakeMove<true>(move, pos);
         // increment nodes count
         info->nodes++;
         // Call Quiescence search recursively
         const int score = -Quiescence<pvNode>(-beta, -alpha, depth - 1, td, ss + 1);
 
         // take move back
-        UnmakeMove(pos, td->keyHistory);
+        UnmakeMove(pos);
 
         if (info->stopped)
             return 0;
@@ -1101,7 +1588,9 @@ int Quiescence(int alpha, int beta, int depth, ThreadData* td, SearchStack* ss)
     // Set the TT bound based on whether we failed high, for qsearch we never use the exact bound
     int bound = bestScore >= beta ? HFLOWER : HFUPPER;
 
-    StoreTTEntry(pos->getPoskey(), MoveToTT(bestmove), ScoreToTT(bestScore, ss->ply), rawEval, bound, 0, pvNode, ttPv);
+    // Just like in Negamax, the scores of a mate search stay out of the TT
+    if (!info->mate)
+        StoreTTEntry(pos->getPoskey(), bestmove, ScoreToTT(bestScore, ss->ply), rawEval, bound, 0, pvNode, ttPv, td->tt);
 
     return bestScore;
 }
@@ -12,20 +12,40 @@ struct SearchStack {
     Move move;
     uint16_t ply;
     Move searchKiller;
+    // The piece that made move, needed by the histories of the later plies once it's no longer on its from square
+    uint8_t movedPiece;
+    // The piece that made the killer, a killer is only tried again if that same piece can play it
+    uint8_t killerPiece;
     int (*contHistEntry)[12 * 64];
     int16_t reduction;
     int moveCount;
 };
 
 
-struct PvTable {
-    int pvLength[MAXDEPTH + 1];
-    Move pvArray[MAXDEPTH + 1][MAXDEPTH + 1];
+// A single line found by a MultiPV search
+struct PvLine {
+    int score = SCORE_NONE;
+    int length = 0;
+    Move moves[MAXDEPTH + 1];
 };
 
-// These 2 tables need to be cleaned after each search. We initialize (and subsequently clean them) elsewhere
-inline PvTable pvTable;
-inline uint64_t nodeSpentTable[64 * 64];
+// Lines found by the main thread in MultiPV mode at the last completed depth, kept sorted from best to worst
+inline PvLine multiPvLines[MAXMULTIPV];
+// Lines of the depth being searched, they only replace the ones above once all of them are done
+inline PvLine multiPvLinesInProgress[MAXMULTIPV];
+
+// Where the last search got to, in analysis mode we use it to resume searching when the new root lies along its pv
+struct LastSearch {
+    // last completed depth and its score
+    int depth = 0;
+    int score = SCORE_NONE;
+    // the pv, along with the keys of the root and of the positions reached by playing its moves
+    int pvLength = 0;
+    Move pvMoves[MAXDEPTH + 1];
+    ZobristKey pvKeys[MAXDEPTH + 1];
+};
+
+inline LastSearch lastSearch;
 
 // ClearForSearch handles the cleaning of the thread data from a clean state
 void ClearForSearch(ThreadData* td);
@@ -48,10 +68,19 @@ template <bool pvNode>
 [[nodiscard]] int Quiescence(int alpha, int beta, int depth,  ThreadData* td, SearchStack* ss);
 
 // Gets best move from PV table
-[[nodiscard]] Move GetBestMove();
+[[nodiscard]] Move GetBestMove(const ThreadData* td);
+
+// Attackers of the squares the captures of a position land on, shared by the SEE of all of them
+struct SEECache {
+    Bitboard attackers[64];
+    Bitboard known = 0;
+};
 
 // inspired by the Weiss engine
 [[nodiscard]] bool SEE(const Position* pos, const Move move, const int threshold);
 
+// Exact value of the exchange started by move, the cache is optional
+[[nodiscard]] int SEEScore(const Position* pos, const Move move, SEECache* cache = nullptr);
+
 // Checks if the current position is a draw
-[[nodiscard]] bool IsDraw(Position* pos, const std::vector<ZobristKey>& keyHistory);
+[[nodiscard]] bool IsDraw(Position* pos);
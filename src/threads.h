@@ -1,20 +1,40 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <thread>
 #include "history.h"
 #include "position.h"
+#include "ttable.h"
 
 enum state {
     Idle,
     Search,
 };
 
+// std::atomic that can be copied, so the structs holding it keep their implicit copy operations, copying just loads the value from one and stores it in the other
+template <typename T>
+struct CopyableAtomic : std::atomic<T> {
+    CopyableAtomic(const T desired = T()) : std::atomic<T>(desired) {}
+    CopyableAtomic(const CopyableAtomic& other) : std::atomic<T>(other.load()) {}
+    CopyableAtomic& operator=(const CopyableAtomic& other) {
+        this->store(other.load());
+        return *this;
+    }
+    using std::atomic<T>::operator=;
+};
+
 // Hold the data from the uci input to set search parameters and some search data to populate the uci output
 struct SearchInfo {
     // search start time
     uint64_t starttime = 0;
+    // The time limits below are rewritten by the uci thread on a ponderhit, the search may only read them once it sees ponder cleared
+    // time our clock started running, it's the same as starttime unless we are pondering
+    uint64_t tmStartTime = 0;
     // search time initial lower bound if present
     uint64_t stoptimeBaseOpt = 0;
     // search time scaled lower bound if present
@@ -30,22 +50,38 @@ struct SearchInfo {
     bool movetimeset = false;
 
     int movestogo = 0;
+    // time left on our clock and increment, kept to set up the time management again on a ponderhit
+    int timeleft = -1;
+    int inc = 0;
     uint64_t nodes = 0;
     uint64_t nodeslimit = 0;
+    // look for a mate in at most this many moves, 0 if we aren't in mate search mode
+    int mate = 0;
+    // if not empty the search is restricted to these root moves
+    std::vector<Move> searchMoves;
 
-    bool stopped = false;
+    // written by the uci thread and the main search thread while the search threads poll it
+    CopyableAtomic<bool> stopped = false;
+    // while pondering all the search limits are suspended, the uci thread clears it on ponderhit or stop
+    CopyableAtomic<bool> ponder = false;
 
     inline void Reset() {
         depth = 0;
         nodes = 0;
         starttime = 0;
+        tmStartTime = 0;
         stoptimeOpt = 0;
         stoptimeMax = 0;
         movestogo = 0;
         stopped = false;
+        ponder = false;
+        timeleft = -1;
+        inc = 0;
         timeset = false;
         movetimeset = false;
         nodeset = false;
+        mate = 0;
+        searchMoves.clear();
     }
 
     inline void print(){
@@ -63,6 +99,8 @@ struct SearchData {
     int rootHistory[2][64 * 64] = {};
     int captHist[12 * 64][6] = {};
     Move counterMoves[64 * 64] = {};
+    // The piece that played each counter move, like killers they are only tried again by that same piece
+    uint8_t counterPieces[64 * 64] = {};
     int contHist[12 * 64][12 * 64] = {};
     int pawnHist[PAWNHIST_SIZE][12 * 64] = {};
     int pawnCorrHist[2][CORRHIST_SIZE] = {};
@@ -71,15 +109,43 @@ struct SearchData {
     int contCorrHist[2][6 * 64][6 * 64] = {};
 };
 
+struct PvTable {
+    int pvLength[MAXDEPTH + 1];
+    Move pvArray[MAXDEPTH + 1][MAXDEPTH + 1];
+};
+
 // a collection of all the data a thread needs to conduct a search
+
 struct ThreadData {
     int id = 0;
     Position pos;
     SearchData sd;
     SearchInfo info;
-    std::vector<ZobristKey> keyHistory;
+    // These 2 tables need to be cleaned after each search, only the main thread of a search fills them
+    PvTable pvTable;
+    uint64_t nodeSpentTable[64 * 64];
+    // The transposition table this thread searches with, the shared one unless the thread has to search on its own
+    TTable* tt = &TT;
+    // The part of the shared TT the thread searches with in deterministic mode, tt points to it then
+    TTable ttSlice;
     int RootDepth;
     int nmpPlies;
+    // Per-thread search parameters used to make the helper threads diverge from the main thread
+    int aspDeltaOffset = 0;
+    int rootNoise = 0;
+    bool skipDepths = false;
+    bool useBreadcrumbs = false;
+    // Score of the search we are resuming in analysis mode, SCORE_NONE when starting from scratch
+    int resumeScore = SCORE_NONE;
+    // The thread checks its own limits instead of waiting for the main thread to stop it, and keeps its own pv
+    bool deterministic = false;
+    // The thread runs its own searches outside of the uci search, so it must never touch the global thread state
+    bool standalone = false;
+    // Result of the last depth the thread completed
+    int completedScore = 0;
+    int completedDepth = 0;
+    // Index of the MultiPV line currently being searched
+    int pvIdx = 0;
 
     NNUE::FinnyTable FTable{};
 
@@ -88,6 +154,27 @@ struct ThreadData {
     }
 };
 
+// A search thread for the commands that run many independent searches in parallel (datagen and analyze)
+// It searches on a private TT and checks its own limits, without ever touching the threads of the uci search
+struct StandaloneThread {
+    std::unique_ptr<ThreadData> td = std::make_unique<ThreadData>();
+    TTable table;
+
+    explicit StandaloneThread(const uint64_t hashMB) {
+        InitTT(hashMB, 1, &table);
+        td->tt = &table;
+        td->standalone = true;
+    }
+
+    ~StandaloneThread() {
+        AlignedFree(table.pTable);
+    }
+
+    // td points into the table, so the struct can't be copied around
+    StandaloneThread(const StandaloneThread&) = delete;
+    StandaloneThread& operator=(const StandaloneThread&) = delete;
+};
+
 // global vector of search threads
 inline std::vector<std::thread> threads;
 // global vector of thread_datas
@@ -101,12 +188,54 @@ inline std::vector<ThreadData> threads_data;
     return nodes;
 }
 
-inline void StopHelperThreads() {
-    // Stop helper threads
-    for (auto& td : threads_data) {
-        td.info.stopped = true;
+// Makes sure there is exactly one thread_data object for each of the threadCount - 1 helper threads
+inline void ResizeThreadsData(const int threadCount) {
+    threads_data.resize(threadCount - 1);
+    for (size_t i = 0; i < threads_data.size(); i++)
+        threads_data[i].id = i + 1;
+}
+
+// In deterministic mode the threads wait for each other at the end of every depth, so they all search the same depths and stop together
+struct SearchBarrier {
+    std::mutex mutex;
+    std::condition_variable cv;
+    // Threads still searching, and how many of them reached the end of the current depth
+    int count = 0;
+    int waiting = 0;
+    // Bumped every time the threads are let through, along with whether they should go on searching
+    uint64_t phase = 0;
+    bool goOn = true;
+    // Set once a thread is done searching, the others stop as soon as they finish the depth they are on
+    bool finished = false;
+    bool stopped = false;
+};
+
+inline SearchBarrier searchBarrier;
+
+// Lets the uci thread block until the current search has printed its bestmove
+inline std::mutex searchDoneMutex;
+inline std::condition_variable searchDoneCv;
+inline bool searchRunning = false;
+
+inline void SetSearchRunning() {
+    std::lock_guard<std::mutex> lock(searchDoneMutex);
+    searchRunning = true;
+}
+
+inline void SignalSearchDone() {
+    {
+        std::lock_guard<std::mutex> lock(searchDoneMutex);
+        searchRunning = false;
     }
+    searchDoneCv.notify_all();
+}
+
+inline void WaitForSearchDone() {
+    std::unique_lock<std::mutex> lock(searchDoneMutex);
+    searchDoneCv.wait(lock, [] { return !searchRunning; });
+}
 
+inline void JoinHelperThreads() {
     for (auto& th : threads) {
         if (th.joinable())
             th.join();
@@ -114,3 +243,19 @@ inline void StopHelperThreads() {
 
     threads.clear();
 }
+
+inline void StopHelperThreads() {
+    // Stop helper threads
+    for (auto& td : threads_data) {
+        td.info.stopped = true;
+    }
+
+    // Wake up the threads waiting at the end of a depth
+    {
+        std::lock_guard<std::mutex> lock(searchBarrier.mutex);
+        searchBarrier.stopped = true;
+    }
+    searchBarrier.cv.notify_all();
+
+    JoinHelperThreads();
+}
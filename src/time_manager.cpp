@@ -12,8 +12,8 @@ void Optimum(SearchInfo* info, int time, int inc) {
     const int safety_overhead = std::min(25, time / 2);
     // if we received a movetime command we need to spend exactly that amount of time on the move, so we don't scale
     if (info->movetimeset) {
-        info->stoptimeMax = info->starttime + time - safety_overhead;
-        info->stoptimeOpt = info->starttime + time - safety_overhead;
+        info->stoptimeMax = info->tmStartTime + time - safety_overhead;
+        info->stoptimeOpt = info->tmStartTime + time - safety_overhead;
         return;
     }
     const bool cyclicTC = info->movestogo != 0;
@@ -29,39 +29,41 @@ void Optimum(SearchInfo* info, int time, int inc) {
     // optime is the time we use to stop if we just cleared a depth
     const auto optime =  optScale * timeLeft;
     info->stoptimeBaseOpt = optime;
-    info->stoptimeOpt = info->starttime + info->stoptimeBaseOpt;
+    info->stoptimeOpt = info->tmStartTime + info->stoptimeBaseOpt;
     // Never use more than 76% of the total time left for a single move
     const auto maxtime = 0.76 * time - safety_overhead;
-    info->stoptimeMax = info->starttime + maxtime;
+    info->stoptimeMax = info->tmStartTime + maxtime;
 }
 
 bool StopEarly(const SearchInfo* info) {
     // check if we used all the nodes/movetime we had or if we used more than our lowerbound of time
-    return (info->timeset || info->movetimeset) && GetTimeMs() > info->stoptimeOpt;
+    return !info->ponder.load(std::memory_order_acquire) && (info->timeset || info->movetimeset) && GetTimeMs() > info->stoptimeOpt;
 }
 
 void ScaleTm(ThreadData* td, const int bestMoveStabilityFactor, const int evalStabilityFactor) {
     const double bestmoveScale[5] = {bmScale1() / 100.0, bmScale2() / 100.0, bmScale3() / 100.0, bmScale4() / 100.0, bmScale5() / 100.0};
     const double evalScale[5] = {evalScale1() / 100.0, evalScale2() / 100.0, evalScale3() / 100.0, evalScale4() / 100.0, evalScale5() / 100.0};
-    const int bestmove = GetBestMove();
+    const int bestmove = GetBestMove(td);
     // Calculate how many nodes were spent on checking the best move
-    const double bestMoveNodesFraction = static_cast<double>(nodeSpentTable[FromTo(bestmove)]) / static_cast<double>(td->info.nodes);
+    const double bestMoveNodesFraction = static_cast<double>(td->nodeSpentTable[FromTo(bestmove)]) / static_cast<double>(td->info.nodes);
     const double nodeScalingFactor = (nodeTmBase() / 100.0 - bestMoveNodesFraction) * (nodeTmMultiplier() / 100.0);
     const double bestMoveScalingFactor = bestmoveScale[bestMoveStabilityFactor];
     const double evalScalingFactor = evalScale[evalStabilityFactor];
     // Scale the search time based on how many nodes we spent and how the best move changed
-    td->info.stoptimeOpt = std::min<uint64_t>(td->info.starttime + td->info.stoptimeBaseOpt * nodeScalingFactor * bestMoveScalingFactor * evalScalingFactor, td->info.stoptimeMax);
+    td->info.stoptimeOpt = std::min<uint64_t>(td->info.tmStartTime + td->info.stoptimeBaseOpt * nodeScalingFactor * bestMoveScalingFactor * evalScalingFactor, td->info.stoptimeMax);
 
 }
 
 bool NodesOver(const SearchInfo* info) {
     // check if we used all the nodes/movetime we had or if we used more than our lowerbound of time
-    return info->nodeset && info->nodes >= info->nodeslimit;
+    return !info->ponder.load(std::memory_order_acquire) && info->nodeset && info->nodes >= info->nodeslimit;
 }
 
 bool TimeOver(const SearchInfo* info) {
     // check if more than Maxtime passed and we have to stop
-    return NodesOver(info) || ((info->timeset || info->movetimeset)
+    // the time limits are only read after seeing ponder cleared, so a ponderhit can't race with us
+    return NodesOver(info) || (!info->ponder.load(std::memory_order_acquire)
+                               && (info->timeset || info->movetimeset)
                                && ((info->nodes & 1023) == 1023)
                                && GetTimeMs() > info->stoptimeMax);
 }
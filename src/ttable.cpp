@@ -1,7 +1,11 @@
 #include "ttable.h"
 #include "io.h"
+#include "search.h"
+#include <algorithm>
 #include <iostream>
 #include <cstdlib>
+#include <thread>
+#include <vector>
 
 // This include breaks on non x86 target platforms
 #if defined(__INTEL_COMPILER) || defined(_MSC_VER)
@@ -39,19 +43,45 @@ void AlignedFree(void *src) {
     #endif
 }
 
-void ClearTT() {
-    for (uint64_t i = 0; i < TT.paddedSize / sizeof(TTBucket); ++i) {
-        TT.pTable[i] = TTBucket();
+// Clears the slice-th of sliceCount equally sized portions of the TT, used to clear the table in parallel
+void ClearTTSlice(const int slice, const int sliceCount, TTable* table) {
+    const uint64_t totalBuckets = table->paddedSize / sizeof(TTBucket);
+    const uint64_t sliceSize = (totalBuckets + sliceCount - 1) / sliceCount;
+    const uint64_t start = std::min<uint64_t>(totalBuckets, slice * sliceSize);
+    const uint64_t end = std::min<uint64_t>(totalBuckets, start + sliceSize);
+    for (uint64_t i = start; i < end; ++i) {
+        table->pTable[i] = TTBucket();
     }
-    TT.age = 1;
 }
 
-void InitTT(uint64_t MB) {
+TTable GetTTSlice(const int slice, const int sliceCount) {
+    const uint64_t sliceBuckets = TT.numBuckets / sliceCount;
+    return TTable{ TT.pTable + slice * sliceBuckets, sliceBuckets, sliceBuckets * sizeof(TTBucket), TT.age };
+}
+
+void ClearTT(const int threadCount, TTable* table) {
+    // Every extra thread clears its own slice of the table while the calling thread takes care of the first one
+    std::vector<std::thread> workers;
+    for (int i = 1; i < threadCount; ++i)
+        workers.emplace_back(ClearTTSlice, i, threadCount, table);
+
+    ClearTTSlice(0, threadCount, table);
+
+    for (auto& worker : workers)
+        worker.join();
+
+    table->age = 1;
+    // An analysis can only be resumed on top of what its last search left in the TT
+    if (table == &TT)
+        lastSearch.depth = 0;
+}
+
+void InitTT(uint64_t MB, const int threadCount, TTable* table) {
     constexpr uint64_t ONE_KB = 1024;
     constexpr uint64_t ONE_MB = ONE_KB * 1024;
     const uint64_t hashSize = ONE_MB * MB;
-    TT.numBuckets = (hashSize / sizeof(TTBucket)) - 3;
-    if (TT.pTable != nullptr) AlignedFree(TT.pTable);
+    table->numBuckets = (hashSize / sizeof(TTBucket)) - 3;
+    if (table->pTable != nullptr) AlignedFree(table->pTable);
 
     // We align to 2MB on Linux (huge pages), otherwise assume that 4KB is the page size
     #if defined(USE_MADVISE)
@@ -61,22 +91,23 @@ void InitTT(uint64_t MB) {
     #endif
 
     // Pad the TT by using a ceil div and a multiply to get the size to be a multiple of `alignment`
-    TT.paddedSize = (TT.numBuckets * sizeof(TTBucket) + alignment - 1) / alignment * alignment;
-    TT.pTable = static_cast<TTBucket*>(AlignedMalloc(TT.paddedSize, alignment));
+    table->paddedSize = (table->numBuckets * sizeof(TTBucket) + alignment - 1) / alignment * alignment;
+    table->pTable = static_cast<TTBucket*>(AlignedMalloc(table->paddedSize, alignment));
 
     // On linux we request huge pages to make use of the 2MB alignment
     #if defined(USE_MADVISE)
-    madvise(TT.pTable, TT.paddedSize, MADV_HUGEPAGE);
+    madvise(table->pTable, table->paddedSize, MADV_HUGEPAGE);
     #endif
 
-    ClearTT();
-    std::cout << "TT init complete with " << TT.numBuckets << " buckets and " << TT.numBuckets * ENTRIES_PER_BUCKET << " entries\n";
+    ClearTT(threadCount, table);
+    if (table == &TT)
+        std::cout << "TT init complete with " << TT.numBuckets << " buckets and " << TT.numBuckets * ENTRIES_PER_BUCKET << " entries\n";
 }
 
-bool ProbeTTEntry(const ZobristKey posKey, TTEntry *tte) {
+bool ProbeTTEntry(const ZobristKey posKey, TTEntry *tte, const TTable* table) {
 
-    const uint64_t index = Index(posKey);
-    TTBucket *bucket = &TT.pTable[index];
+    const uint64_t index = Index(posKey, table);
+    TTBucket *bucket = &table->pTable[index];
     for (int i = 0; i < ENTRIES_PER_BUCKET; i++) {
         *tte = bucket->entries[i];
         if (tte->ttKey == static_cast<TTKey>(posKey)) {
@@ -86,12 +117,12 @@ bool ProbeTTEntry(const ZobristKey posKey, TTEntry *tte) {
     return false;
 }
 
-void StoreTTEntry(const ZobristKey key, const PackedMove move, int score, int eval, const int bound, const int depth, const bool pv, const bool wasPV) {
+void StoreTTEntry(const ZobristKey key, const Move move, int score, int eval, const int bound, const int depth, const bool pv, const bool wasPV, TTable* table) {
     // Calculate index based on the position key and get the entry that already fills that index
-    const uint64_t index = Index(key);
+    const uint64_t index = Index(key, table);
     const TTKey key16 = static_cast<TTKey>(key);
-    const uint8_t TTAge = TT.age;
-    TTBucket* bucket = &TT.pTable[index];
+    const uint8_t TTAge = table->age;
+    TTBucket* bucket = &table->pTable[index];
     TTEntry* tte = &bucket->entries[0];
     for (int i = 0; i < ENTRIES_PER_BUCKET; i++) {
         TTEntry* entry = &bucket->entries[i];
@@ -125,28 +156,28 @@ void StoreTTEntry(const ZobristKey key, const PackedMove move, int score, int ev
     }
 }
 
-int GetHashfull() {
+int GetHashfull(const TTable* table) {
     int hit = 0;
     for (int i = 0; i < 2000; i++) {
-        const TTBucket *bucket = &TT.pTable[i];
+        const TTBucket *bucket = &table->pTable[i];
         for (int idx = 0; idx < ENTRIES_PER_BUCKET; idx++) {
             const TTEntry *tte = &bucket->entries[idx];
-            if (tte->ttKey != 0 && AgeFromTT(tte->ageBoundPV) == TT.age)
+            if (tte->ttKey != 0 && AgeFromTT(tte->ageBoundPV) == table->age)
                 hit++;
         }
     }
     return hit / (2 * ENTRIES_PER_BUCKET);
 }
 
-uint64_t Index(const ZobristKey posKey) {
+uint64_t MulHi64(const uint64_t key, const uint64_t size) {
 #ifdef __SIZEOF_INT128__
-    return static_cast<uint64_t>(((static_cast<__uint128_t>(posKey) * static_cast<__uint128_t>(TT.numBuckets)) >> 64));
+    return static_cast<uint64_t>(((static_cast<__uint128_t>(key) * static_cast<__uint128_t>(size)) >> 64));
 #else
     // Workaround to use the correct bits when indexing the TT on a platform with no int128 support, code s̶t̶o̶l̶e̶n̶ f̶r̶o̶m̶ provided by Nanopixel
-    uint64_t xlo = static_cast<uint32_t>(posKey);
-    uint64_t xhi = posKey >> 32;
-    uint64_t nlo = static_cast<uint32_t>(TT.numBuckets);
-    uint64_t nhi = TT.numBuckets >> 32;
+    uint64_t xlo = static_cast<uint32_t>(key);
+    uint64_t xhi = key >> 32;
+    uint64_t nlo = static_cast<uint32_t>(size);
+    uint64_t nhi = size >> 32;
     uint64_t c1 = (xlo * nlo) >> 32;
     uint64_t c2 = (xhi * nlo) + c1;
     uint64_t c3 = (xlo * nhi) + static_cast<uint32_t>(c2);
@@ -155,6 +186,10 @@ uint64_t Index(const ZobristKey posKey) {
 #endif
 }
 
+uint64_t Index(const ZobristKey posKey, const TTable* table) {
+    return MulHi64(posKey, table->numBuckets);
+}
+
 // prefetches the data in the given address in l1/2 cache in a non blocking way.
 void prefetch(const void* addr) {
 #if defined(__INTEL_COMPILER) || defined(_MSC_VER)
@@ -164,8 +199,8 @@ void prefetch(const void* addr) {
 #endif
 }
 
-void TTPrefetch(const ZobristKey posKey) {
-    prefetch(&TT.pTable[Index(posKey)].entries[0]);
+void TTPrefetch(const ZobristKey posKey, const TTable* table) {
+    prefetch(&table->pTable[Index(posKey, table)].entries[0]);
 }
 
 
@@ -187,19 +222,6 @@ int ScoreFromTT(int score, int ply) {
     return score;
 }
 
-PackedMove MoveToTT(Move move) {
-    return (move & 0xffff);
-}
-
-Move MoveFromTT(Position *pos, PackedMove packed_move) {
-    // It's important to preserve a move being null even it's being unpacked
-    if (packed_move == NOMOVE)
-        return NOMOVE;
-
-    const int piece = pos->PieceOn(From(packed_move));
-    return packed_move | (piece << 16);
-}
-
 uint8_t BoundFromTT(uint8_t ageBoundPV) {
     return ageBoundPV & 0b00000011;
 }
@@ -216,6 +238,6 @@ uint8_t PackToTT(uint8_t bound, bool wasPV, uint8_t age) {
     return static_cast<uint8_t>(bound + (wasPV << 2) + (age << 3));
 }
 
-void UpdateTableAge() {
-    TT.age = (TT.age + 1) & AGE_MASK;
+void UpdateTableAge(TTable* table) {
+    table->age = (table->age + 1) & AGE_MASK;
 }
@@ -14,7 +14,7 @@ constexpr int ENTRIES_PER_BUCKET = 3;
 // 1 for depth
 // 1 for age + bound + PV
 PACK(struct TTEntry {
-    PackedMove move = NOMOVE;
+    Move move = NOMOVE;
     int16_t score = SCORE_NONE;
     int16_t eval = SCORE_NONE;
     TTKey ttKey = 0;
@@ -48,28 +48,32 @@ void* AlignedMalloc(size_t size, size_t alignment);
 
 void AlignedFree(void *src);
 
-void ClearTT();
+// All the functions working on a table default to the shared TT
+// Clears one of sliceCount equally sized slices of the TT
+void ClearTTSlice(const int slice, const int sliceCount, TTable* table = &TT);
+// Clears the whole TT, splitting the work among threadCount threads
+void ClearTT(const int threadCount = 1, TTable* table = &TT);
+// Returns a table made of one of sliceCount equally sized slices of the shared TT, the slice shares the memory of the TT
+[[nodiscard]] TTable GetTTSlice(const int slice, const int sliceCount);
 // Initialize an TT of size MB
-void InitTT(uint64_t MB);
+void InitTT(uint64_t MB, const int threadCount = 1, TTable* table = &TT);
 
-[[nodiscard]] bool ProbeTTEntry(const ZobristKey posKey, TTEntry* tte);
+[[nodiscard]] bool ProbeTTEntry(const ZobristKey posKey, TTEntry* tte, const TTable* table = &TT);
 
-void StoreTTEntry(const ZobristKey key, const PackedMove move, int score, int eval, const int bound, const int depth, const bool pv, const bool wasPV);
+void StoreTTEntry(const ZobristKey key, const Move move, int score, int eval, const int bound, const int depth, const bool pv, const bool wasPV, TTable* table = &TT);
 
-[[nodiscard]] uint64_t Index(const ZobristKey posKey);
+// Maps a key to [0, size) using the upper 64 bits of their product
+[[nodiscard]] uint64_t MulHi64(const uint64_t key, const uint64_t size);
+[[nodiscard]] uint64_t Index(const ZobristKey posKey, const TTable* table = &TT);
 
-[[nodiscard]] int GetHashfull();
+[[nodiscard]] int GetHashfull(const TTable* table = &TT);
 
-void TTPrefetch(const ZobristKey posKey);
+void TTPrefetch(const ZobristKey posKey, const TTable* table = &TT);
 
 int ScoreToTT(int score, int ply);
 
 int ScoreFromTT(int score, int ply);
 
-PackedMove MoveToTT(Move move);
-
-Move MoveFromTT(Position *pos, PackedMove packed_move);
-
 uint8_t BoundFromTT(uint8_t ageBoundPV);
 
 bool FormerPV(uint8_t ageBoundPV);
@@ -78,4 +82,4 @@ uint8_t AgeFromTT(uint8_t ageBoundPV);
 
 uint8_t PackToTT(uint8_t bound, bool wasPV, uint8_t age);
 
-void UpdateTableAge();
\ No newline at end of file
+void UpdateTableAge(TTable* table = &TT);
\ No newline at end of file
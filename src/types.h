@@ -17,13 +17,17 @@ using Bitboard = uint64_t;
 using TTKey = uint16_t;
 // define poskey data type
 using ZobristKey = uint64_t;
-using Move = uint32_t;
-using PackedMove = uint16_t;
+// from square, to square and movetype, the moved piece is whatever stands on the from square
+using Move = uint16_t;
 using Square = uint8_t;
 
 constexpr Move NOMOVE = 0;
 constexpr int MAXPLY = 256;
+// Game plies whose keys we keep track of, older ones get dropped once they can't be repeated anymore
+constexpr int MAXGAMEPLY = 1024;
 constexpr int MAXDEPTH = MAXPLY;
+constexpr int MAXMULTIPV = 256;
+constexpr int MAXTHREADS = 256;
 constexpr int MATE_SCORE = 32000;
 constexpr int MATE_FOUND = MATE_SCORE - MAXPLY;
 constexpr int SCORE_NONE = 32001;
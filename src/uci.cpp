@@ -1,4 +1,7 @@
+#include "analyze.h"
 #include "bench.h"
+#include "datagen.h"
+#include "movebench.h"
 #include "uci.h"
 #include "misc.h"
 #include "types.h"
@@ -12,6 +15,8 @@
 #include "position.h"
 #include "movegen.h"
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 #include "tune.h"
 #include "eval.h"
 
@@ -20,8 +25,8 @@ Move ParseMove(const std::string& moveString, Position* pos) {
     // create move list instance
     MoveList moveList;
 
-    // generate moves
-    GenerateMoves(&moveList, pos, MOVEGEN_ALL);
+    // generate the legal moves, anything else is rejected
+    GenerateLegalMoves(&moveList, pos);
 
     // parse source square
     const unsigned int sourceSquare = (moveString[0] - 'a') + (8 - (moveString[1] - '0')) * 8;
@@ -32,7 +37,7 @@ Move ParseMove(const std::string& moveString, Position* pos) {
     // loop over the moves within a move list
     for (int move_count = 0; move_count < moveList.count; move_count++) {
         // init move
-        const Move move = moveList.moves[move_count].move;
+        const Move move = moveList.moves[move_count];
         // make sure source & target squares are available within the generated move
         if (sourceSquare == From(move) &&
             targetSquare == To(move)) {
@@ -68,40 +73,77 @@ Move ParseMove(const std::string& moveString, Position* pos) {
     return NOMOVE;
 }
 
+// The last position command we parsed, if the next one just adds some moves to it we only have to play the new ones
+static struct {
+    const Position* pos = nullptr;
+    std::string base;
+    std::vector<std::string> moves;
+    ZobristKey key = 0;
+    int keyCount = 0;
+} lastPosition;
+
 // parse UCI "position" command
-void ParsePosition(const std::string& command, Position* pos, std::vector<ZobristKey>& keyHistory) {
+void ParsePosition(const std::string& command, Position* pos) {
+    // Split the command in the part that sets up the starting position and the moves played from there
+    const auto movesStart = command.find("moves");
+    // Trim the base so that "position startpos" and "position startpos moves ..." share the same one
+    std::string base = command.substr(0, movesStart);
+    base.erase(base.find_last_not_of(" \t\r\n") + 1);
+    std::vector<std::string> moves;
+    // Avoid looking for a moves that doesn't exist in the case of "position startpos moves <blank>" (Needed for Scid support)
+    if (movesStart != std::string::npos && command.length() >= movesStart + 6)
+        moves = split_command(command.substr(movesStart + 6));
+
+    // Check if the position is still the one we left after the last command and the new move list extends the old one
+    if (   pos == lastPosition.pos
+        && base == lastPosition.base
+        && pos->getPoskey() == lastPosition.key
+        && pos->keyHistory.size() == lastPosition.keyCount
+        && moves.size() >= lastPosition.moves.size()
+        && std::equal(lastPosition.moves.begin(), lastPosition.moves.end(), moves.begin())) {
+        parse_moves(std::span(moves).subspan(lastPosition.moves.size()), pos);
+        lastPosition.moves = std::move(moves);
+        lastPosition.key = pos->getPoskey();
+        lastPosition.keyCount = pos->keyHistory.size();
+        return;
+    }
+
     // parse UCI "startpos" command
-    if (command.find("startpos") != std::string::npos) {
+    if (base.find("startpos") != std::string::npos) {
         // init chess board with start position
         ParseFen(start_position, pos);
-        keyHistory.clear();
     }
 
     // parse UCI "fen" command
     else {
         // if a "fen" command is available within command string
-        if (command.find("fen") != std::string::npos) {
+        if (base.find("fen") != std::string::npos) {
             // Substring from after "fen" up to "moves"
             std::string position = getPosition(command);
             ParseFen(position, pos);
-            keyHistory.clear();
-        }
+            }
         else {
             // init chess board with start position
             ParseFen(start_position, pos);
-            keyHistory.clear();
-        }
+            }
     }
 
     // if there are moves to be played in the fen play them
-    if (command.find("moves") != std::string::npos) {
-        auto string_start = command.find("moves") + 6;
-        // Avoid looking for a moves that doesn't exist in the case of "position startpos moves <blank>" (Needed for Scid support)
-        if (command.length() >= string_start) {
-            std::string moves_substr = command.substr(string_start, std::string::npos);
-            parse_moves(moves_substr, pos, keyHistory);
-        }
-    }
+    parse_moves(moves, pos);
+
+    lastPosition.pos = pos;
+    lastPosition.base = base;
+    lastPosition.moves = std::move(moves);
+    lastPosition.key = pos->getPoskey();
+    lastPosition.keyCount = pos->keyHistory.size();
+}
+
+// Checks if a token has the shape of a move in coordinate notation (e.g. "e2e4" or "e7e8q"), so it can tell moves apart from the other go parameters
+static bool IsMoveString(const std::string& token) {
+    const auto isFile = [](const char c) { return c >= 'a' && c <= 'h'; };
+    const auto isRank = [](const char c) { return c >= '1' && c <= '8'; };
+    return (token.size() == 4 || (token.size() == 5 && std::string("qrbn").find(token[4]) != std::string::npos))
+        && isFile(token[0]) && isRank(token[1]) && isFile(token[2]) && isRank(token[3]);
 }
 
 // parse UCI "go" command, returns true if we have to search afterwards and false otherwise
@@ -119,11 +161,6 @@ bool ParseGo(const std::string& line, SearchInfo* info, Position* pos) {
             ;
         }
 
-        if (tokens.at(1) == "perft") {
-           std::cout << "perft support is currently broken, soz";
-            return false;
-        }
-
         if (tokens.at(i) == "binc" && pos->side == BLACK) {
             inc = std::stoi(tokens[i + 1]);
         }
@@ -153,6 +190,25 @@ bool ParseGo(const std::string& line, SearchInfo* info, Position* pos) {
             info->movetimeset = true;
         }
 
+        // every token after searchmoves that is a legal move is a root move we are allowed to search
+        if (tokens.at(i) == "searchmoves") {
+            while (i + 1 < tokens.size() && IsMoveString(tokens[i + 1])) {
+                const Move move = ParseMove(tokens[i + 1], pos);
+                if (move == NOMOVE)
+                    break;
+                info->searchMoves.push_back(move);
+                i++;
+            }
+        }
+
+        if (tokens.at(i) == "mate") {
+            info->mate = std::max(1, std::stoi(tokens[i + 1]));
+        }
+
+        if (tokens.at(i) == "ponder") {
+            info->ponder = true;
+        }
+
         if (tokens.at(i) == "depth") {
             depth = std::stoi(tokens[i + 1]);
         }
@@ -163,8 +219,10 @@ bool ParseGo(const std::string& line, SearchInfo* info, Position* pos) {
         }
     }
 
-    info->starttime = GetTimeMs();
+    info->starttime = info->tmStartTime = GetTimeMs();
     info->depth = depth;
+    info->timeleft = time;
+    info->inc = inc;
     // calculate time allocation for the move
     Optimum(info, time, inc);
 
@@ -174,22 +232,128 @@ bool ParseGo(const std::string& line, SearchInfo* info, Position* pos) {
     return true;
 }
 
+// parse the "bench [depth] [threads] [hash] [movetime]" command, returns false if any of the arguments is invalid
+bool ParseBench(const std::vector<std::string>& tokens, int& depth, int& threadCount, int& hash, int& movetime) {
+    depth = 14;
+    threadCount = 1;
+    hash = 64;
+    movetime = 0;
+    int* args[] = { &depth, &threadCount, &hash, &movetime };
+    const char* names[] = { "depth", "threads", "hash", "movetime" };
+    for (size_t i = 1; i < tokens.size() && i <= 4; i++) {
+        const int value = std::atoi(tokens[i].c_str());
+        // a movetime of 0 is used to request a depth limited bench
+        if (value < (i == 4 ? 0 : 1)) {
+            std::cout << "Invalid bench " << names[i - 1] << std::endl;
+            return false;
+        }
+        *args[i - 1] = value;
+    }
+    return true;
+}
+
+// parse the "movebench [text|csv|json] [file]" command, returns false if the format is unknown
+bool ParseMoveBench(const std::vector<std::string>& tokens) {
+    if (tokens.size() > 1 && tokens[1] != "text" && tokens[1] != "csv" && tokens[1] != "json") {
+        std::cout << "Invalid movebench format, use text, csv or json" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// parse the "datagen [threads] [games] [nodes] [file]" command, returns false if any of the arguments is invalid
+bool ParseDatagen(const std::vector<std::string>& tokens, int& threadCount, int& games, int& nodes, std::string& fileName) {
+    threadCount = 1;
+    games = 100;
+    nodes = 5000;
+    fileName = "data.bin";
+    int* args[] = { &threadCount, &games, &nodes };
+    const char* names[] = { "threads", "games", "nodes" };
+    for (size_t i = 1; i < tokens.size() && i <= 3; i++) {
+        const int value = std::atoi(tokens[i].c_str());
+        if (value < 1) {
+            std::cout << "Invalid datagen " << names[i - 1] << std::endl;
+            return false;
+        }
+        *args[i - 1] = value;
+    }
+    if (tokens.size() > 4)
+        fileName = tokens[4];
+    return true;
+}
+
+// parse the "analyze <file> [threads] [depth] [nodes] [output]" command, returns false if any of the arguments is invalid
+bool ParseAnalyze(const std::vector<std::string>& tokens, std::string& inputFile, int& threadCount, int& depth, uint64_t& nodes, std::string& outputFile) {
+    if (tokens.size() < 2) {
+        std::cout << "Missing analyze file" << std::endl;
+        return false;
+    }
+    inputFile = tokens[1];
+    threadCount = 1;
+    depth = 10;
+    nodes = 0;
+    outputFile = inputFile + ".out";
+    if (tokens.size() > 2)
+        threadCount = std::atoi(tokens[2].c_str());
+    if (tokens.size() > 3)
+        depth = std::atoi(tokens[3].c_str());
+    // a node limit of 0 means the search is only depth limited
+    if (tokens.size() > 4) {
+        const char* nodesArg = tokens[4].c_str();
+        char* end;
+        nodes = std::strtoull(nodesArg, &end, 10);
+        if (end == nodesArg || *end != '\0' || nodesArg[0] == '-') {
+            std::cout << "Invalid analyze nodes" << std::endl;
+            return false;
+        }
+    }
+    if (tokens.size() > 5)
+        outputFile = tokens[5];
+    if (threadCount < 1 || depth < 1 || depth > MAXDEPTH) {
+        std::cout << "Invalid analyze " << (threadCount < 1 ? "threads" : "depth") << std::endl;
+        return false;
+    }
+    return true;
+}
+
 // main UCI loop
 void UciLoop(int argc, char** argv) {
     if (argv[1] && strncmp(argv[1], "bench", 5) == 0) {
-        int benchDepth = 14;
-        // If there's an additional input try to parse it as a bench depth
-        if (argc == 3) {
-            if (std::stoi(argv[2]) > 0) {
-                benchDepth = std::stoi(argv[2]);
-            }
-            else {
-                std::cout << "Invalid bench depth";
-                return;
-            }
-        }
+        std::vector<std::string> tokens(argv + 1, argv + argc);
+        int benchDepth, benchThreads, benchHash, benchMovetime;
+        if (!ParseBench(tokens, benchDepth, benchThreads, benchHash, benchMovetime))
+            return;
         tryhardmode = true;
-        StartBench(benchDepth);
+        StartBench(benchDepth, benchThreads, benchHash, benchMovetime);
+        return;
+    }
+
+    if (argv[1] && strncmp(argv[1], "movebench", 9) == 0) {
+        std::vector<std::string> tokens(argv + 1, argv + argc);
+        if (!ParseMoveBench(tokens))
+            return;
+        StartMoveBench(tokens.size() > 1 ? tokens[1] : "text", tokens.size() > 2 ? tokens[2] : "");
+        return;
+    }
+
+    if (argv[1] && strncmp(argv[1], "analyze", 7) == 0) {
+        std::vector<std::string> tokens(argv + 1, argv + argc);
+        std::string analyzeInput, analyzeOutput;
+        int analyzeThreads, analyzeDepth;
+        uint64_t analyzeNodes;
+        if (!ParseAnalyze(tokens, analyzeInput, analyzeThreads, analyzeDepth, analyzeNodes, analyzeOutput))
+            return;
+        StartAnalyze(analyzeInput, analyzeThreads, analyzeDepth, analyzeNodes, analyzeOutput);
+        return;
+    }
+
+    if (argv[1] && strncmp(argv[1], "datagen", 7) == 0) {
+        std::vector<std::string> tokens(argv + 1, argv + argc);
+        int datagenThreads, datagenGames, datagenNodes;
+        std::string datagenFile;
+        if (!ParseDatagen(tokens, datagenThreads, datagenGames, datagenNodes, datagenFile))
+            return;
+        StartDatagen(datagenThreads, datagenGames, datagenNodes, datagenFile);
         return;
     }
 
@@ -231,12 +395,18 @@ void UciLoop(int argc, char** argv) {
         // parse UCI "position" command
         if (tokens[0] == "position") {
             // call parse position function
-            ParsePosition(input, &td->pos, td->keyHistory);
+            ParsePosition(input, &td->pos);
             parsed_position = true;
         }
 
         // parse UCI "go" command
         else if (tokens[0] == "go") {
+            // A search that is still pondering would never end on its own, so we stop it
+            if (td->info.ponder) {
+                td->info.stopped = true;
+                td->info.ponder = false;
+                td->info.ponder.notify_all();
+            }
             StopHelperThreads();
             // Join previous search thread if it exists
             if (main_thread.joinable())
@@ -246,13 +416,25 @@ void UciLoop(int argc, char** argv) {
 #endif
 
             if (!parsed_position) { // call parse position function
-                ParsePosition("position startpos", &td->pos, td->keyHistory);
+                ParsePosition("position startpos", &td->pos);
+            }
+            // "go perft <depth> [hash]" runs a perft test on the current position instead of a search
+            if (tokens.size() > 1 && tokens[1] == "perft") {
+                const int perftDepth = tokens.size() > 2 ? std::atoi(tokens[2].c_str()) : 0;
+                const int perftHash = tokens.size() > 3 ? std::atoi(tokens[3].c_str()) : 0;
+                if (perftDepth < 1 || perftHash < 0) {
+                    std::cout << "Invalid perft " << (perftDepth < 1 ? "depth" : "hash") << std::endl;
+                    continue;
+                }
+                PerftTest(perftDepth, &td->pos, uciOptions.Threads, perftHash);
+                continue;
             }
             // call parse go function
             bool search = ParseGo(input, &td->info, &td->pos);
             // Start search in a separate thread
             if (search) {
                 threads_state = Search;
+                SetSearchRunning();
                 main_thread = std::thread(RootSearch, td->info.depth, td, &uciOptions);
             }
         }
@@ -266,16 +448,54 @@ void UciLoop(int argc, char** argv) {
             if (tokens.at(2) == "Hash") {
                 uciOptions.Hash = std::stoi(tokens.at(4));
                 std::cout << "Set Hash to " << uciOptions.Hash << " MB" << std::endl;
-                InitTT(uciOptions.Hash);
+                InitTT(uciOptions.Hash, uciOptions.Threads);
             }
             else if (tokens.at(2) == "Threads") {
-                uciOptions.Threads = std::stoi(tokens.at(4));
-                std::cout << "Set Threads to " << uciOptions.Threads << std::endl;;
+                uciOptions.Threads = std::clamp(std::stoi(tokens.at(4)), 1, MAXTHREADS);
+                std::cout << "Set Threads to " << uciOptions.Threads << std::endl;
+                // The helpers of a running search are still using their thread data, so the search has to be over before we resize it
+                if (main_thread.joinable()) {
+                    StopHelperThreads();
+                    td->info.stopped = true;
+                    td->info.ponder = false;
+                    td->info.ponder.notify_all();
+                    main_thread.join();
+                    threads_state = Idle;
+                }
+                // Allocate the helpers' data right away rather than on the first search
+                ResizeThreadsData(uciOptions.Threads);
             }
             else if (tokens.at(2) == "Minimal") {
                 auto value = tokens.at(4) == "true";
                 uciOptions.shortUci = value;
             }
+            else if (tokens.at(2) == "SMPSkipDepths") {
+                uciOptions.SMPSkipDepths = tokens.at(4) == "true";
+            }
+            else if (tokens.at(2) == "SMPDepthOffset") {
+                uciOptions.SMPDepthOffset = std::clamp(std::stoi(tokens.at(4)), 0, 8);
+            }
+            else if (tokens.at(2) == "SMPRootNoise") {
+                uciOptions.SMPRootNoise = std::clamp(std::stoi(tokens.at(4)), 0, 4096);
+            }
+            else if (tokens.at(2) == "SMPAspDelta") {
+                uciOptions.SMPAspDelta = std::clamp(std::stoi(tokens.at(4)), 0, 64);
+            }
+            else if (tokens.at(2) == "Ponder") {
+                // Nothing to set up, the gui tells us when to ponder with go ponder
+            }
+            else if (tokens.at(2) == "UCI_AnalyseMode") {
+                uciOptions.UCI_AnalyseMode = tokens.at(4) == "true";
+            }
+            else if (tokens.at(2) == "MultiPV") {
+                uciOptions.MultiPV = std::clamp(std::stoi(tokens.at(4)), 1, MAXMULTIPV);
+            }
+            else if (tokens.at(2) == "Deterministic") {
+                uciOptions.Deterministic = tokens.at(4) == "true";
+            }
+            else if (tokens.at(2) == "SMPBreadcrumbs") {
+                uciOptions.SMPBreadcrumbs = tokens.at(4) == "true";
+            }
 
 #ifdef TUNE
             else {
@@ -293,8 +513,20 @@ void UciLoop(int argc, char** argv) {
 
         // parse UCI "ucinewgame" command
         else if (input == "ucinewgame") {
-            InitNewGame(td);
+            InitNewGame(td, uciOptions.Threads);
         }
+        // parse UCI "ponderhit" command, the opponent played the move we were pondering on so we keep searching with the normal time limits
+        else if (input == "ponderhit") {
+            if (threads_state == Search && td->info.ponder) {
+                // Our clock starts running now, the time spent pondering comes for free
+                // The search doesn't look at its time limits while pondering, so they can be rewritten as long as that happens before ponder is cleared
+                td->info.tmStartTime = GetTimeMs();
+                Optimum(&td->info, td->info.timeleft, td->info.inc);
+                td->info.ponder.store(false, std::memory_order_release);
+                td->info.ponder.notify_all();
+            }
+        }
+
         // parse UCI "stop" command
         else if (input == "stop") {
             if (threads_state == Search) {
@@ -302,18 +534,18 @@ void UciLoop(int argc, char** argv) {
                 StopHelperThreads();
                 // stop main thread search
                 td->info.stopped = true;
+                // a search that was pondering is now allowed to send its bestmove
+                td->info.ponder = false;
+                td->info.ponder.notify_all();
                 if (main_thread.joinable())
                     main_thread.join();
             }
             threads_state = Idle;
         }
 
-        // parse UCI "position" command
+        // parse "wait" command, blocks until the current search is over and has printed its bestmove
         else if (input == "wait") {
-            // call parse position function
-            while (!td->info.stopped) {
-                ;
-            }
+            WaitForSearchDone();
             if (main_thread.joinable())
                 main_thread.join();
         }
@@ -325,6 +557,8 @@ void UciLoop(int argc, char** argv) {
                 StopHelperThreads();
                 // stop main thread search
                 td->info.stopped = true;
+                td->info.ponder = false;
+                td->info.ponder.notify_all();
             }
             // Join previous search thread if it exists
             if (main_thread.joinable())
@@ -344,6 +578,15 @@ void UciLoop(int argc, char** argv) {
             std::cout << "option name Hash type spin default 16 min 1 max 262144 \n";
             std::cout << "option name Threads type spin default 1 min 1 max 256 \n";
             std::cout << "option name Minimal type check default false \n";
+            std::cout << "option name Ponder type check default false \n";
+            std::cout << "option name UCI_AnalyseMode type check default false \n";
+            std::cout << "option name MultiPV type spin default 1 min 1 max 256 \n";
+            std::cout << "option name SMPSkipDepths type check default false \n";
+            std::cout << "option name SMPDepthOffset type spin default 0 min 0 max 8 \n";
+            std::cout << "option name SMPRootNoise type spin default 0 min 0 max 4096 \n";
+            std::cout << "option name SMPAspDelta type spin default 0 min 0 max 64 \n";
+            std::cout << "option name SMPBreadcrumbs type check default false \n";
+            std::cout << "option name Deterministic type check default false \n";
 #ifdef TUNE
             // spsa info dump
             for (const auto &param: tunables()) {
@@ -362,17 +605,49 @@ void UciLoop(int argc, char** argv) {
 
         else if (input == "eval") {// call parse position function
             if (!parsed_position) {
-                ParsePosition("position startpos", &td->pos, td->keyHistory);
+                ParsePosition("position startpos", &td->pos);
             }
             std::cout << "Raw eval: " << EvalPositionRaw(&td->pos, &td->FTable) << std::endl;
 
             std::cout << "Scaled eval: " << adjustEval(&td->pos, 0, EvalPosition(&td->pos, &td->FTable)) << std::endl;
         }
 
-        else if (input == "bench") {
+        else if (tokens[0] == "bench") {
+            int benchDepth, benchThreads, benchHash, benchMovetime;
+            if (!ParseBench(tokens, benchDepth, benchThreads, benchHash, benchMovetime))
+                continue;
             tryhardmode = true;
-            StartBench();
+            StartBench(benchDepth, benchThreads, benchHash, benchMovetime);
             tryhardmode = false;
+            // The bench uses its own settings and leaves its search data in the helpers, restore the session like a ucinewgame would
+            // but keep the position the gui set up, a go after the bench has to search that one
+            const Position savedPos = td->pos;
+            InitTT(uciOptions.Hash, uciOptions.Threads);
+            InitNewGame(td, uciOptions.Threads);
+            td->pos = savedPos;
+        }
+
+        else if (tokens[0] == "movebench") {
+            if (!ParseMoveBench(tokens))
+                continue;
+            StartMoveBench(tokens.size() > 1 ? tokens[1] : "text", tokens.size() > 2 ? tokens[2] : "");
+        }
+
+        else if (tokens[0] == "analyze") {
+            std::string analyzeInput, analyzeOutput;
+            int analyzeThreads, analyzeDepth;
+            uint64_t analyzeNodes;
+            if (!ParseAnalyze(tokens, analyzeInput, analyzeThreads, analyzeDepth, analyzeNodes, analyzeOutput))
+                continue;
+            StartAnalyze(analyzeInput, analyzeThreads, analyzeDepth, analyzeNodes, analyzeOutput);
+        }
+
+        else if (tokens[0] == "datagen") {
+            int datagenThreads, datagenGames, datagenNodes;
+            std::string datagenFile;
+            if (!ParseDatagen(tokens, datagenThreads, datagenGames, datagenNodes, datagenFile))
+                continue;
+            StartDatagen(datagenThreads, datagenGames, datagenNodes, datagenFile);
         }
 
         else if (input == "see") {
@@ -381,15 +656,11 @@ void UciLoop(int argc, char** argv) {
 
             // generate moves
             GenerateMoves(&moveList, &td->pos, MOVEGEN_ALL);
-            printf("SEE thresholds\n");
+            printf("SEE values\n");
+            SEECache cache;
             for (int i = 0; i < moveList.count; i++) {
-                Move move = moveList.moves[i].move;
-                for (int j = 1200; j > -1200; j--) {
-                    if (SEE(&td->pos, move, j)) {
-                        printf(" move number %d  %s SEE result: %d \n", i + 1, FormatMove(move), j);
-                        break;
-                    }
-                }
+                Move move = moveList.moves[i];
+                printf(" move number %d  %s SEE result: %d \n", i + 1, FormatMove(move), SEEScore(&td->pos, move, &cache));
             }
         }
         else std::cout << "Unknown command: " << input << std::endl;
@@ -2,6 +2,7 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include "move.h"
 
 struct Position;
@@ -9,9 +10,20 @@ struct SearchInfo;
 
 struct UciOptions {
     uint64_t Hash = 16;
-    static constexpr int MultiPV = 1;
+    int MultiPV = 1;
+    // Resume the search of consecutive positions that follow the pv of the last search
+    bool UCI_AnalyseMode = false;
     int Threads = 1;
     bool shortUci = false;
+    // Lazy SMP diversification of the helper threads
+    bool SMPSkipDepths = false;
+    int SMPDepthOffset = 0;
+    int SMPRootNoise = 0;
+    int SMPAspDelta = 0;
+    // Make multithreaded node limited searches reproducible by giving each thread its own slice of the TT and node budget
+    bool Deterministic = false;
+    // Mark the nodes close to the root that are being searched so other threads can avoid duplicating work
+    bool SMPBreadcrumbs = false;
 };
 
 // Internal flag to decide if to pretty or ugly print search results
@@ -21,10 +33,22 @@ inline bool tryhardmode = false;
 // Parse a move from algebraic notation to the engine's internal encoding
 [[nodiscard]] Move ParseMove(const std::string& move_string, Position* pos);
 // parse UCI "position" command
-void ParsePosition(const std::string& command, Position* pos, std::vector<ZobristKey>& keyHistory);
+void ParsePosition(const std::string& command, Position* pos);
 
 // parse UCI "go" command
 [[nodiscard]] bool ParseGo(const std::string& line, SearchInfo* info, Position* pos);
 
+// parse the "bench" command arguments
+[[nodiscard]] bool ParseBench(const std::vector<std::string>& tokens, int& depth, int& threadCount, int& hash, int& movetime);
+
+// parse the "movebench" command arguments
+[[nodiscard]] bool ParseMoveBench(const std::vector<std::string>& tokens);
+
+// parse the "datagen" command arguments
+[[nodiscard]] bool ParseDatagen(const std::vector<std::string>& tokens, int& threadCount, int& games, int& nodes, std::string& fileName);
+
+// parse the "analyze" command arguments
+[[nodiscard]] bool ParseAnalyze(const std::vector<std::string>& tokens, std::string& inputFile, int& threadCount, int& depth, uint64_t& nodes, std::string& outputFile);
+
 // main UCI loop
 void UciLoop(int argc, char** argv);